@@ -0,0 +1,196 @@
+#include "GridBench.h"
+
+#include "EntityTable.h"
+#include "SpatialGrid.h"
+#include "StubRuntime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	constexpr float RADIUS = 300.0f;
+	constexpr size_t K = 8;
+	constexpr size_t MAX_QUERIES = 500;
+
+	using Clock = std::chrono::steady_clock;
+
+	float DistSq(const Vector& a, const Vector& b)
+	{
+		const float dx = b.x - a.x;
+		const float dz = b.z - a.z;
+		return dx * dx + dz * dz;
+	}
+
+	// Times fn over every query, repeated until it has run for a while.
+	// Returns microseconds per query.
+	template <typename Fn>
+	double TimeQueries(size_t queries, Fn&& fn)
+	{
+		int repeats = 0;
+		const auto start = Clock::now();
+		auto elapsed = Clock::duration::zero();
+		do
+		{
+			for (size_t q = 0; q < queries; ++q)
+				fn(q);
+			++repeats;
+			elapsed = Clock::now() - start;
+		} while (elapsed < std::chrono::milliseconds(20));
+		return std::chrono::duration<double, std::micro>(elapsed).count() / (static_cast<double>(repeats) * queries);
+	}
+
+	// Brute force versions, the same scans the game's own proximity functions do
+
+	int NearestByScan(const EntityTable& table, const Vector& center, float maxDist, TeamNum team)
+	{
+		const auto positions = table.GetPositions();
+		float bestSq = maxDist * maxDist;
+		int best = -1;
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			const float distSq = DistSq(center, positions[i]);
+			if (table.GetTeamNum(i) != team && distSq <= bestSq && (distSq < bestSq || best < 0))
+			{
+				bestSq = distSq;
+				best = static_cast<int>(i);
+			}
+		}
+		return best;
+	}
+
+	void KNearestByScan(const EntityTable& table, const Vector& center, size_t k, float maxDist,
+		std::vector<std::pair<float, uint32_t>>& hits, std::vector<uint32_t>& out)
+	{
+		const auto positions = table.GetPositions();
+		const float maxSq = maxDist * maxDist;
+		hits.clear();
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			const float distSq = DistSq(center, positions[i]);
+			if (distSq <= maxSq)
+				hits.emplace_back(distSq, static_cast<uint32_t>(i));
+		}
+		const size_t count = std::min(k, hits.size());
+		std::partial_sort(hits.begin(), hits.begin() + count, hits.end());
+		out.clear();
+		for (size_t i = 0; i < count; ++i)
+			out.push_back(hits[i].second);
+	}
+
+	int CountByScan(const EntityTable& table, const Vector& center, float radius, TeamNum team)
+	{
+		const auto positions = table.GetPositions();
+		const float radiusSq = radius * radius;
+		int count = 0;
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			if (table.GetTeamNum(i) == team && DistSq(center, positions[i]) <= radiusSq)
+				++count;
+		}
+		return count;
+	}
+}
+
+int RunGridBenchmark(uint32_t seed)
+{
+	const int SIZES[] = { 100, 500, 1000, 2500, 5000, 10000 };
+
+	std::printf("%8s %9s  %-17s %-17s %-17s %s\n", "objects", "build us",
+		"nearest us", "k-nearest us", "count us", "same");
+	std::printf("%8s %9s  %8s %8s %8s %8s %8s %8s\n", "", "",
+		"grid", "scan", "grid", "scan", "grid", "scan");
+
+	bool ok = true;
+	for (int size : SIZES)
+	{
+		StubRuntime::Config config;
+		config.objectCount = size;
+		config.seed = seed;
+		StubRuntime::Init(config);
+
+		EntityTable table;
+		for (Handle h : StubRuntime::GetHandles())
+			table.Add(h);
+		table.Refresh(GetLockstepTurn());
+
+		SpatialGrid grid;
+		grid.Build(table);
+		int builds = 0;
+		const auto buildStart = Clock::now();
+		auto buildTime = Clock::duration::zero();
+		do
+		{
+			grid.Build(table);
+			++builds;
+			buildTime = Clock::now() - buildStart;
+		} while (buildTime < std::chrono::milliseconds(20));
+
+		// Query from the objects' own positions, the way mission logic does
+		const size_t queries = std::min(table.Size(), MAX_QUERIES);
+		const auto positions = table.GetPositions();
+
+		std::vector<uint32_t> gridOut;
+		std::vector<uint32_t> scanOut;
+		std::vector<SpatialGrid::Neighbor> heap;
+		std::vector<std::pair<float, uint32_t>> hits;
+
+		// Same answers first, then time
+		bool same = true;
+		for (size_t q = 0; q < queries; ++q)
+		{
+			const Vector& center = positions[q];
+			const TeamNum team = table.GetTeamNum(q);
+			same &= grid.FindNearest(center, RADIUS, [&](uint32_t j) { return table.GetTeamNum(j) != team; })
+				== NearestByScan(table, center, RADIUS, team);
+			grid.FindKNearest(center, K, RADIUS, gridOut, heap, [](uint32_t) { return true; });
+			KNearestByScan(table, center, K, RADIUS, hits, scanOut);
+			same &= gridOut == scanOut;
+			same &= grid.CountInRadius(center, RADIUS, [&](uint32_t j) { return table.GetTeamNum(j) == team; })
+				== CountByScan(table, center, RADIUS, team);
+		}
+		ok &= same;
+
+		// Keeps the optimizer from dropping the query loops
+		long long sink = 0;
+		const double nearestGrid = TimeQueries(queries, [&](size_t q)
+		{
+			const TeamNum team = table.GetTeamNum(q);
+			sink += grid.FindNearest(positions[q], RADIUS, [&](uint32_t j) { return table.GetTeamNum(j) != team; });
+		});
+		const double nearestScan = TimeQueries(queries, [&](size_t q)
+		{
+			sink += NearestByScan(table, positions[q], RADIUS, table.GetTeamNum(q));
+		});
+		const double knnGrid = TimeQueries(queries, [&](size_t q)
+		{
+			sink += grid.FindKNearest(positions[q], K, RADIUS, gridOut, heap, [](uint32_t) { return true; });
+		});
+		const double knnScan = TimeQueries(queries, [&](size_t q)
+		{
+			KNearestByScan(table, positions[q], K, RADIUS, hits, scanOut);
+			sink += scanOut.size();
+		});
+		const double countGrid = TimeQueries(queries, [&](size_t q)
+		{
+			const TeamNum team = table.GetTeamNum(q);
+			sink += grid.CountInRadius(positions[q], RADIUS, [&](uint32_t j) { return table.GetTeamNum(j) == team; });
+		});
+		const double countScan = TimeQueries(queries, [&](size_t q)
+		{
+			sink += CountByScan(table, positions[q], RADIUS, table.GetTeamNum(q));
+		});
+
+		std::printf("%8zu %9.1f  %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %s\n", table.Size(),
+			std::chrono::duration<double, std::micro>(buildTime).count() / builds,
+			nearestGrid, nearestScan, knnGrid, knnScan, countGrid, countScan,
+			same ? "yes" : "NO");
+		if (sink == -1)
+			std::printf("\n");
+	}
+
+	return ok ? 0 : 1;
+}
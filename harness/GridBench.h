@@ -0,0 +1,12 @@
+#ifndef _GridBench_
+#define _GridBench_
+
+#include <cstdint>
+
+// Times SpatialGrid's Build and queries against scanning every object,
+// for StubRuntime worlds from 100 to 10000 objects, and checks both give
+// the same answers. Reinitializes the stub world. Returns nonzero on a
+// mismatch.
+int RunGridBenchmark(uint32_t seed);
+
+#endif
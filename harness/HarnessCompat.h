@@ -0,0 +1,10 @@
+#ifndef _HarnessCompat_
+#define _HarnessCompat_
+
+// Force-included ahead of everything in the harness build. ScriptUtils.h
+// uses MSVC calling convention and DLL import/export keywords, which mean
+// nothing for a single static executable.
+#define __cdecl
+#define __declspec(x)
+
+#endif
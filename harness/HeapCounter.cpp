@@ -0,0 +1,58 @@
+#include "HeapCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace
+{
+	std::atomic<uint64_t> s_Allocations{ 0 };
+
+	void* Allocate(std::size_t size)
+	{
+		s_Allocations.fetch_add(1, std::memory_order_relaxed);
+		if (void* p = std::malloc(size ? size : 1))
+			return p;
+		throw std::bad_alloc();
+	}
+
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		s_Allocations.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+		void* p = _aligned_malloc(size ? size : 1, align);
+#else
+		void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+		if (p)
+			return p;
+		throw std::bad_alloc();
+	}
+
+	void FreeAligned(void* p)
+	{
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+}
+
+uint64_t HeapAllocations()
+{
+	return s_Allocations.load(std::memory_order_relaxed);
+}
+
+// The array and nothrow forms go through these by default
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
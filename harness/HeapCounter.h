@@ -0,0 +1,11 @@
+#ifndef _HeapCounter_
+#define _HeapCounter_
+
+#include <cstdint>
+
+// Number of operator new calls so far in the harness process. The
+// harness replaces the global allocation functions to count them, so
+// the difference across a tick is how much it touched the heap.
+uint64_t HeapAllocations();
+
+#endif
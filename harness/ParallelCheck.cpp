@@ -0,0 +1,70 @@
+#include "ParallelCheck.h"
+
+#include "RandomStream.h"
+#include "WorkerPool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int RunParallelCheck(uint32_t seed)
+{
+	constexpr size_t COUNT = 1000000;
+	constexpr size_t GRAIN = 1024;
+	const int THREADS[] = { 1, 2, 4, 16 };
+
+	// Mixed magnitudes, so a sum added up in a different order would come out different
+	std::vector<float> input(COUNT);
+	RandomStream random(seed);
+	for (float& v : input)
+		v = random.Float(-1.0f, 1.0f) * std::pow(10.0f, static_cast<float>(random.Int(-4, 4)));
+
+	std::vector<float> reference;
+	uint32_t referenceBits = 0;
+	bool ok = true;
+
+	std::printf("%8s %12s %12s %10s %10s\n", "threads", "sum bits", "us/run", "steals", "result");
+	for (int threads : THREADS)
+	{
+		WorkerPool pool;
+		pool.Start(threads);
+
+		std::vector<float> output(COUNT);
+		float sum = 0.0f;
+		constexpr int RUNS = 10;
+		const auto start = std::chrono::steady_clock::now();
+		for (int run = 0; run < RUNS; ++run)
+		{
+			pool.ParallelFor(COUNT, GRAIN, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+					output[i] = std::sqrt(std::fabs(input[i])) * 1.5f + std::cos(input[i]);
+			});
+			sum = pool.ParallelReduce(COUNT, GRAIN, 0.0f, [&](size_t begin, size_t end)
+			{
+				float partial = 0.0f;
+				for (size_t i = begin; i < end; ++i)
+					partial += output[i] * input[i];
+				return partial;
+			}, [](float a, float b) { return a + b; });
+		}
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+
+		uint32_t bits = 0;
+		std::memcpy(&bits, &sum, sizeof(bits));
+		if (reference.empty())
+		{
+			reference = output;
+			referenceBits = bits;
+		}
+		const bool same = bits == referenceBits && output == reference;
+		ok &= same;
+
+		std::printf("%8d     %08x %12.0f %10llu %10s\n", pool.GetThreadCount(), bits,
+			std::chrono::duration<double, std::micro>(elapsed).count() / RUNS,
+			static_cast<unsigned long long>(pool.GetStats().steals), same ? "same" : "MISMATCH");
+	}
+	return ok ? 0 : 1;
+}
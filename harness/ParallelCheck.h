@@ -0,0 +1,11 @@
+#ifndef _ParallelCheck_
+#define _ParallelCheck_
+
+#include <cstdint>
+
+// Runs WorkerPool::ParallelFor and a float ParallelReduce over 1M items
+// with 1, 2, 4 and 16 workers and checks every run gives the same bits.
+// Returns nonzero on a mismatch.
+int RunParallelCheck(uint32_t seed);
+
+#endif
@@ -0,0 +1,114 @@
+#include "RandomCheck.h"
+
+#include "RandomStream.h"
+#include "SaveBuffer.h"
+#include "StubRuntime.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	constexpr int FRAMES = 200;
+
+	// Frame seeds the way the game hands them out, same on every machine
+	unsigned long FrameSeed(uint32_t seed, int frame)
+	{
+		return static_cast<unsigned long>(seed * 2654435761u + frame);
+	}
+
+	struct Draws
+	{
+		std::vector<uint32_t> spawner;
+		std::vector<uint32_t> ai;
+		std::vector<uint32_t> loot;
+
+		bool operator==(const Draws&) const = default;
+	};
+
+	// A few frames of each stream being used. extraSpawner draws more from
+	// SPWN on every frame, which must not show up anywhere else.
+	void Play(RandomStreams& streams, uint32_t seed, int firstFrame, int frames, int extraSpawner, Draws& draws)
+	{
+		RandomStream& spawner = streams.Get(RANDOM_SPAWNER);
+		RandomStream& ai = streams.Get(RANDOM_AI);
+		RandomStream& loot = streams.Get(RANDOM_LOOT);
+		for (int frame = firstFrame; frame < firstFrame + frames; ++frame)
+		{
+			streams.SetSeed(FrameSeed(seed, frame));
+			for (int i = 0; i < 3 + extraSpawner; ++i)
+				draws.spawner.push_back(spawner.Next());
+			for (int i = 0; i < 5; ++i)
+				draws.ai.push_back(ai.Next());
+			draws.loot.push_back(loot.Next());
+		}
+	}
+
+	bool Report(const char* name, bool ok)
+	{
+		std::printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+		return ok;
+	}
+}
+
+int RunRandomCheck(uint32_t seed)
+{
+	bool ok = true;
+
+	// Same seeds, same numbers
+	Draws first;
+	Draws second;
+	{
+		RandomStreams streams;
+		Play(streams, seed, 0, FRAMES, 0, first);
+	}
+	{
+		RandomStreams streams;
+		Play(streams, seed, 0, FRAMES, 0, second);
+	}
+	ok &= Report("repeat run gives the same sequences", first == second);
+
+	// Extra spawner draws only change the spawner
+	Draws busy;
+	{
+		RandomStreams streams;
+		Play(streams, seed, 0, FRAMES, 4, busy);
+	}
+	ok &= Report("extra SPWN draws leave AI and LOOT alone", busy.ai == first.ai && busy.loot == first.loot && busy.spawner != first.spawner);
+
+	// Save halfway, load into fresh streams, and the second half matches
+	Draws uninterrupted;
+	Draws resumed;
+	{
+		RandomStreams streams;
+		Play(streams, seed, 0, FRAMES / 2, 0, uninterrupted);
+
+		StubRuntime::ClearSave();
+		SaveWriter writer;
+		streams.Save(writer);
+		writer.Flush();
+
+		Play(streams, seed, FRAMES / 2, FRAMES / 2, 0, uninterrupted);
+	}
+	{
+		StubRuntime::RewindSave();
+		SaveReader reader;
+		RandomStreams streams;
+		const bool loaded = reader.Load() && streams.Load(reader);
+		ok &= Report("save loads", loaded);
+
+		Play(streams, seed, FRAMES / 2, FRAMES / 2, 0, resumed);
+	}
+	// Each half draws the same amount, so the resumed run is the back half
+	auto backHalf = [](const std::vector<uint32_t>& all, const std::vector<uint32_t>& tail)
+	{
+		return all.size() == tail.size() * 2 && std::equal(tail.begin(), tail.end(), all.begin() + tail.size());
+	};
+	ok &= Report("Save/Load resumes the same sequences",
+		backHalf(uninterrupted.spawner, resumed.spawner)
+		&& backHalf(uninterrupted.ai, resumed.ai)
+		&& backHalf(uninterrupted.loot, resumed.loot));
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#ifndef _RandomCheck_
+#define _RandomCheck_
+
+#include <cstdint>
+
+// Checks RandomStreams gives the same SPWN/AI/LOOT sequences from the same
+// seeds, that extra draws on one stream leave the others alone, and that
+// Save/Load picks up exactly where the save left off. Returns nonzero on
+// a failure.
+int RunRandomCheck(uint32_t seed);
+
+#endif
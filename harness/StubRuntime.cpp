@@ -0,0 +1,839 @@
+#include "StubRuntime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	struct Object
+	{
+		Vector position;
+		Vector velocity;
+		TeamNum team;
+		float health;
+		int category;
+		const char* cfg;
+		size_t index;
+		AiCommand command;
+		Handle who;
+		Vector where;
+		Handle target;
+	};
+
+	// Neutral plus two opposing sides (see IsTeamAllied)
+	const TeamNum TEAMS[] = { 0, 1, 6 };
+
+	const char* const CFGS[] = { "ivtank", "ivscout", "ivmisl", "ivturr", "fvtank", "fvscout", "ibscav", "fbrecy" };
+
+	StubRuntime::Config s_Config;
+	std::mt19937 s_Rng;
+	long s_Turn = 0;
+	Handle s_NextHandle = 1;
+	std::unordered_map<Handle, Object> s_Objects;
+	std::vector<Handle> s_Handles;
+
+	// Who's aiming at each handle. Entries go stale when targets change or
+	// objects go away; WhoIsTargeting checks them against the objects.
+	std::unordered_map<Handle, std::vector<Handle>> s_TargetedBy;
+
+	// AI paths by name, and the name pointers GetAiPaths hands out
+	std::map<std::string, std::vector<VECTOR_2D>> s_Paths;
+	std::vector<char*> s_PathNames;
+
+	std::vector<uint8_t> s_SaveData;
+	size_t s_SaveCursor = 0;
+
+	// Room for every export in ScriptUtils.h
+	constexpr size_t MAX_EXPORTS = 1024;
+	StubRuntime::ExportCount s_Counts[MAX_EXPORTS];
+	size_t s_ExportCount = 0;
+	uint64_t s_TotalCalls = 0;
+
+	size_t RegisterExport(const char* name)
+	{
+		s_Counts[s_ExportCount] = { name, 0 };
+		return s_ExportCount++;
+	}
+
+	float RandomRange(float lo, float hi)
+	{
+		return std::uniform_real_distribution<float>(lo, hi)(s_Rng);
+	}
+
+	Object* FindObject(Handle h)
+	{
+		auto it = s_Objects.find(h);
+		return it != s_Objects.end() ? &it->second : nullptr;
+	}
+
+	// Rolling hills, with water in the lowest parts
+	float TerrainHeight(float x, float z)
+	{
+		return 40.0f * std::sin(x / 300.0f) * std::cos(z / 250.0f);
+	}
+
+	constexpr float WATER_HEIGHT = -30.0f;
+
+	void SetObjectTarget(Handle me, Handle target)
+	{
+		Object* obj = FindObject(me);
+		if (!obj || obj->target == target)
+			return;
+		obj->target = target;
+		if (target == 0)
+			return;
+		std::vector<Handle>& who = s_TargetedBy[target];
+		if (std::find(who.begin(), who.end(), me) == who.end())
+			who.push_back(me);
+	}
+
+	// Orders just record what the unit was told, nothing moves because of them
+	void SetOrder(Handle me, AiCommand command, Handle who, const Vector& where)
+	{
+		if (Object* obj = FindObject(me))
+		{
+			obj->command = command;
+			obj->who = who;
+			obj->where = where;
+		}
+		if (command == CMD_ATTACK)
+			SetObjectTarget(me, who);
+	}
+}
+
+// Each stub registers itself the first time it runs, so the report lists
+// exports in first-call order. Overloads need COUNT_EXPORT_AS to tell them apart.
+#define COUNT_EXPORT_AS(name) \
+	static const size_t exportIndex_ = RegisterExport(name); \
+	++s_Counts[exportIndex_].calls; \
+	++s_TotalCalls
+#define COUNT_EXPORT() COUNT_EXPORT_AS(__func__)
+
+void StubRuntime::Init(const Config& config)
+{
+	s_Config = config;
+	s_Rng.seed(config.seed);
+	s_Turn = 0;
+	s_NextHandle = 1;
+	s_Objects.clear();
+	s_Handles.clear();
+	s_TargetedBy.clear();
+	s_SaveData.clear();
+	s_SaveCursor = 0;
+
+	// A few random paths so path code has something to chew on
+	s_Paths.clear();
+	const float half = config.worldSize * 0.5f;
+	for (int i = 0; i < 16; ++i)
+	{
+		std::vector<VECTOR_2D>& points = s_Paths["path_" + std::to_string(i)];
+		for (int p = 0; p < 8; ++p)
+			points.emplace_back(RandomRange(-half, half), RandomRange(-half, half));
+	}
+
+	for (int i = 0; i < config.objectCount; ++i)
+		SpawnObject();
+}
+
+void StubRuntime::Step()
+{
+	++s_Turn;
+
+	const float dt = 1.0f / static_cast<float>(s_Config.tps);
+	const float half = s_Config.worldSize * 0.5f;
+	for (Handle h : s_Handles)
+	{
+		Object& obj = s_Objects[h];
+		obj.position.x += obj.velocity.x * dt;
+		obj.position.z += obj.velocity.z * dt;
+
+		// Bounce off the map edges
+		if (std::fabs(obj.position.x) > half)
+			obj.velocity.x = -obj.velocity.x;
+		if (std::fabs(obj.position.z) > half)
+			obj.velocity.z = -obj.velocity.z;
+	}
+}
+
+Handle StubRuntime::SpawnObject()
+{
+	const float half = s_Config.worldSize * 0.5f;
+
+	Object obj{};
+	obj.position = Vector(RandomRange(-half, half), 0.0f, RandomRange(-half, half));
+	obj.velocity = Vector(RandomRange(-20.0f, 20.0f), 0.0f, RandomRange(-20.0f, 20.0f));
+	obj.team = TEAMS[s_Rng() % std::size(TEAMS)];
+	obj.health = 1.0f;
+	obj.category = static_cast<int>(s_Rng() % 4);
+	obj.cfg = CFGS[s_Rng() % std::size(CFGS)];
+	obj.index = s_Handles.size();
+
+	const Handle h = s_NextHandle++;
+	s_Objects[h] = obj;
+	s_Handles.push_back(h);
+	return h;
+}
+
+void StubRuntime::RemoveObject(Handle h)
+{
+	auto it = s_Objects.find(h);
+	if (it == s_Objects.end())
+		return;
+
+	const size_t index = it->second.index;
+	const Handle last = s_Handles.back();
+	s_Handles[index] = last;
+	s_Objects[last].index = index;
+	s_Handles.pop_back();
+	s_Objects.erase(it);
+}
+
+Handle StubRuntime::PickObject()
+{
+	if (s_Handles.empty())
+		return 0;
+	return s_Handles[s_Rng() % s_Handles.size()];
+}
+
+std::span<const Handle> StubRuntime::GetHandles()
+{
+	return s_Handles;
+}
+
+void StubRuntime::ClearSave()
+{
+	s_SaveData.clear();
+	s_SaveCursor = 0;
+}
+
+void StubRuntime::RewindSave()
+{
+	s_SaveCursor = 0;
+}
+
+std::span<const StubRuntime::ExportCount> StubRuntime::GetExportCounts()
+{
+	return { s_Counts, s_ExportCount };
+}
+
+uint64_t StubRuntime::GetTotalExportCalls()
+{
+	return s_TotalCalls;
+}
+
+void StubRuntime::ResetExportCounts()
+{
+	for (size_t i = 0; i < s_ExportCount; ++i)
+		s_Counts[i].calls = 0;
+	s_TotalCalls = 0;
+}
+
+// Exports
+
+void DLLAPI PrintConsoleMessage(const char* msg)
+{
+	COUNT_EXPORT();
+	std::printf("%s\n", msg);
+}
+
+unsigned long DLLAPI CalcCRC(ConstName n)
+{
+	COUNT_EXPORT();
+	// FNV-1a, the game's CRC just has to be stable
+	unsigned long crc = 2166136261u;
+	for (; n && *n; ++n)
+		crc = (crc ^ static_cast<unsigned char>(*n)) * 16777619u;
+	return crc;
+}
+
+long DLLAPI GetLockstepTurn(void)
+{
+	COUNT_EXPORT();
+	return s_Turn;
+}
+
+int DLLAPI SecondsToTurns(float timeSeconds)
+{
+	COUNT_EXPORT();
+	return static_cast<int>(timeSeconds * s_Config.tps + 0.5f);
+}
+
+float DLLAPI TurnsToSeconds(int turns)
+{
+	COUNT_EXPORT();
+	return static_cast<float>(turns) / static_cast<float>(s_Config.tps);
+}
+
+bool DLLAPI GetAllGameObjectHandles(size_t& bufSize, Handle* pData)
+{
+	COUNT_EXPORT();
+	if (!pData || bufSize < s_Handles.size())
+	{
+		bufSize = s_Handles.size();
+		return false;
+	}
+	std::copy(s_Handles.begin(), s_Handles.end(), pData);
+	bufSize = s_Handles.size();
+	return true;
+}
+
+bool DLLAPI IsAround(Handle h)
+{
+	COUNT_EXPORT();
+	return FindObject(h) != nullptr;
+}
+
+bool DLLAPI IsAlive2(Handle h)
+{
+	COUNT_EXPORT();
+	return FindObject(h) != nullptr;
+}
+
+void DLLAPI GetPosition(Handle h, Vector& pos)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	pos = obj ? obj->position : Vector(0.0f, 0.0f, 0.0f);
+}
+
+Vector DLLAPI GetVelocity(Handle h)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	return obj ? obj->velocity : Vector(0.0f, 0.0f, 0.0f);
+}
+
+TeamNum DLLAPI GetTeamNum(Handle h)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	return obj ? obj->team : 0;
+}
+
+float DLLAPI GetHealth(Handle h)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	return obj ? obj->health : 0.0f;
+}
+
+int DLLAPI GetCategoryType(Handle h)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	return obj ? obj->category : -1;
+}
+
+bool DLLAPI GetObjInfo(Handle h, ObjectInfoType type, char pBuffer[64])
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	if (!obj || (type != Get_CFG && type != Get_ODF))
+		return false;
+	std::snprintf(pBuffer, 64, type == Get_ODF ? "%s.odf" : "%s", obj->cfg);
+	return true;
+}
+
+float DLLAPI GetTerrainMinX(void)
+{
+	COUNT_EXPORT();
+	return -s_Config.worldSize * 0.5f;
+}
+
+float DLLAPI GetTerrainMaxX(void)
+{
+	COUNT_EXPORT();
+	return s_Config.worldSize * 0.5f;
+}
+
+float DLLAPI GetTerrainMinZ(void)
+{
+	COUNT_EXPORT();
+	return -s_Config.worldSize * 0.5f;
+}
+
+float DLLAPI GetTerrainMaxZ(void)
+{
+	COUNT_EXPORT();
+	return s_Config.worldSize * 0.5f;
+}
+
+// The real ones are bit-exact across CPUs, the CRT is close enough here
+
+float DLLAPI portable_sin(const float ang)
+{
+	COUNT_EXPORT();
+	return std::sin(ang);
+}
+
+float DLLAPI portable_cos(const float ang)
+{
+	COUNT_EXPORT();
+	return std::cos(ang);
+}
+
+float DLLAPI portable_atan2(const float x, const float y)
+{
+	COUNT_EXPORT();
+	return std::atan2(x, y);
+}
+
+float DLLAPI portable_asin(const float x)
+{
+	COUNT_EXPORT();
+	return std::asin(x);
+}
+
+float DLLAPI portable_acos(const float x)
+{
+	COUNT_EXPORT();
+	return std::acos(x);
+}
+
+// ODFs are all empty: every lookup misses and returns its default
+
+bool DLLAPI OpenODF(const char* name)
+{
+	COUNT_EXPORT();
+	return name != nullptr;
+}
+
+bool DLLAPI CloseODF(const char* name)
+{
+	COUNT_EXPORT();
+	return name != nullptr;
+}
+
+int DLLAPI GetODFInt(const char* file, const char* block, const char* name, int* value, int defval)
+{
+	COUNT_EXPORT();
+	if (value)
+		*value = defval;
+	return 0;
+}
+
+int DLLAPI GetODFFloat(const char* file, const char* block, const char* name, float* value, float defval)
+{
+	COUNT_EXPORT();
+	if (value)
+		*value = defval;
+	return 0;
+}
+
+int DLLAPI GetODFBool(const char* file, const char* block, const char* name, bool* value, bool defval)
+{
+	COUNT_EXPORT();
+	if (value)
+		*value = defval;
+	return 0;
+}
+
+int DLLAPI GetODFString(const char* file, const char* block, const char* name, size_t ValueLen, char* value, const char* defval)
+{
+	COUNT_EXPORT();
+	if (value && ValueLen > 0)
+	{
+		std::strncpy(value, defval ? defval : "", ValueLen - 1);
+		value[ValueLen - 1] = '\0';
+	}
+	return 0;
+}
+
+// Save data goes to an in-memory buffer, see ClearSave/RewindSave
+
+bool DLLAPI Write(void* ptr, int bytesize)
+{
+	COUNT_EXPORT_AS("Write(void*)");
+	const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+	s_SaveData.insert(s_SaveData.end(), bytes, bytes + bytesize);
+	return true;
+}
+
+bool DLLAPI Write(int* i_array, int i_count)
+{
+	COUNT_EXPORT_AS("Write(int*)");
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(i_array);
+	s_SaveData.insert(s_SaveData.end(), bytes, bytes + sizeof(int) * i_count);
+	return true;
+}
+
+bool DLLAPI Read(void* ptr, int bytesize)
+{
+	COUNT_EXPORT_AS("Read(void*)");
+	if (bytesize < 0 || s_SaveCursor + bytesize > s_SaveData.size())
+		return false;
+	std::memcpy(ptr, s_SaveData.data() + s_SaveCursor, bytesize);
+	s_SaveCursor += bytesize;
+	return true;
+}
+
+bool DLLAPI Read(int* i_array, int i_count)
+{
+	COUNT_EXPORT_AS("Read(int*)");
+	const size_t bytesize = sizeof(int) * i_count;
+	if (i_count < 0 || s_SaveCursor + bytesize > s_SaveData.size())
+		return false;
+	std::memcpy(i_array, s_SaveData.data() + s_SaveCursor, bytesize);
+	s_SaveCursor += bytesize;
+	return true;
+}
+
+void DLLAPI ConvertHandles(Handle* h_array, int h_count)
+{
+	COUNT_EXPORT();
+	// Handles never change across a stub save/load
+}
+
+bool DLLAPI IsAudioMessageDone(int msg)
+{
+	COUNT_EXPORT();
+	return true;
+}
+
+bool DLLAPI CameraPath(ConstName path_name, int height, int speed, Handle target_handle)
+{
+	COUNT_EXPORT();
+	return true;
+}
+
+bool DLLAPI CameraCancelled(void)
+{
+	COUNT_EXPORT();
+	return false;
+}
+
+void DLLAPI Goto(Handle me, const Vector& pos, int priority)
+{
+	COUNT_EXPORT_AS("Goto(Vector)");
+	SetOrder(me, CMD_GO, 0, pos);
+}
+
+void DLLAPI Goto(Handle me, Handle him, int priority)
+{
+	COUNT_EXPORT_AS("Goto(Handle)");
+	SetOrder(me, CMD_GO, him, Vector(0.0f, 0.0f, 0.0f));
+}
+
+void DLLAPI Goto(Handle me, ConstName path, int priority)
+{
+	COUNT_EXPORT_AS("Goto(path)");
+	SetOrder(me, CMD_GO, 0, Vector(0.0f, 0.0f, 0.0f));
+}
+
+void DLLAPI Attack(Handle me, Handle him, int priority)
+{
+	COUNT_EXPORT();
+	SetOrder(me, CMD_ATTACK, him, Vector(0.0f, 0.0f, 0.0f));
+}
+
+void DLLAPI Follow(Handle me, Handle him, int priority)
+{
+	COUNT_EXPORT();
+	SetOrder(me, CMD_FOLLOW, him, Vector(0.0f, 0.0f, 0.0f));
+}
+
+void DLLAPI Defend(Handle me, int priority)
+{
+	COUNT_EXPORT();
+	SetOrder(me, CMD_DEFEND, 0, Vector(0.0f, 0.0f, 0.0f));
+}
+
+void DLLAPI Patrol(Handle me, ConstName path, int priority)
+{
+	COUNT_EXPORT();
+	SetOrder(me, CMD_PATROL, 0, Vector(0.0f, 0.0f, 0.0f));
+}
+
+void DLLAPI SetCommand(Handle me, int cmd, int priority, Handle who, const Vector& where, int param)
+{
+	COUNT_EXPORT_AS("SetCommand(Vector)");
+	SetOrder(me, static_cast<AiCommand>(cmd), who, where);
+}
+
+void DLLAPI SetCommand(Handle me, int cmd, int priority, Handle who, ConstName path, int param)
+{
+	COUNT_EXPORT_AS("SetCommand(path)");
+	SetOrder(me, static_cast<AiCommand>(cmd), who, Vector(0.0f, 0.0f, 0.0f));
+}
+
+AiCommand DLLAPI GetCurrentCommand(Handle me)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(me);
+	return obj ? obj->command : CMD_NONE;
+}
+
+Handle DLLAPI GetCurrentWho(Handle me)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(me);
+	return obj ? obj->who : 0;
+}
+
+Vector DLLAPI GetCurrentCommandWhere(Handle h)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	return obj ? obj->where : Vector(0.0f, 0.0f, 0.0f);
+}
+
+// The MisnExport2 callbacks are accepted but never raised
+
+void DLLAPI SetPreSnipeCallback(PreSnipeCallback callback)
+{
+	COUNT_EXPORT();
+}
+
+void DLLAPI SetPreOrdnanceHitCallback(PreOrdnanceHitCallback callback)
+{
+	COUNT_EXPORT();
+}
+
+void DLLAPI SetPreGetInCallback(PreGetInCallback callback)
+{
+	COUNT_EXPORT();
+}
+
+void DLLAPI SetPrePickupPowerupCallback(PrePickupPowerupCallback callback)
+{
+	COUNT_EXPORT();
+}
+
+void DLLAPI SetPostTargetChangedCallback(PostTargetChangedCallback callback)
+{
+	COUNT_EXPORT();
+}
+
+void DLLAPI SetChatMessageSentCallback(ChatMessageSentCallback callback)
+{
+	COUNT_EXPORT();
+}
+
+void DLLAPI GetAiPaths(int& pathCount, char**& pathNames)
+{
+	COUNT_EXPORT();
+	s_PathNames.clear();
+	for (auto& [name, points] : s_Paths)
+		s_PathNames.push_back(const_cast<char*>(name.c_str()));
+	pathCount = static_cast<int>(s_PathNames.size());
+	pathNames = s_PathNames.data();
+}
+
+bool DLLAPI GetPathPoints(ConstName path, size_t& bufSize, float* pData)
+{
+	COUNT_EXPORT();
+	auto it = s_Paths.find(path);
+	if (it == s_Paths.end())
+	{
+		bufSize = 0;
+		return false;
+	}
+	if (!pData || bufSize < it->second.size())
+	{
+		bufSize = it->second.size();
+		return false;
+	}
+	bufSize = it->second.size();
+	std::memcpy(pData, it->second.data(), bufSize * sizeof(VECTOR_2D));
+	return true;
+}
+
+bool DLLAPI CreatePath(ConstName name, float x, float z)
+{
+	COUNT_EXPORT();
+	auto [it, inserted] = s_Paths.try_emplace(name);
+	if (inserted)
+		it->second.emplace_back(x, z);
+	return inserted;
+}
+
+int DLLAPI AddPathPoint(ConstName name, float x, float z)
+{
+	COUNT_EXPORT();
+	auto it = s_Paths.find(name);
+	if (it == s_Paths.end())
+		return -1;
+	it->second.emplace_back(x, z);
+	return static_cast<int>(it->second.size());
+}
+
+bool DLLAPI RenamePath(ConstName oldname, ConstName newname)
+{
+	COUNT_EXPORT();
+	auto it = s_Paths.find(oldname);
+	if (it == s_Paths.end() || s_Paths.count(newname))
+		return false;
+	s_Paths[newname] = std::move(it->second);
+	s_Paths.erase(oldname);
+	return true;
+}
+
+bool DLLAPI RemovePath(ConstName name)
+{
+	COUNT_EXPORT();
+	return s_Paths.erase(name) != 0;
+}
+
+int DLLAPI RemovePathPoint(ConstName name, int point)
+{
+	COUNT_EXPORT();
+	auto it = s_Paths.find(name);
+	if (it == s_Paths.end())
+		return -1;
+	if (point < 0 || point >= static_cast<int>(it->second.size()))
+		return -2;
+	if (it->second.size() == 1)
+	{
+		s_Paths.erase(it);
+		return 0;
+	}
+	it->second.erase(it->second.begin() + point);
+	return static_cast<int>(it->second.size());
+}
+
+bool DLLAPI SetPathPoint(ConstName name, int point, float x, float z)
+{
+	COUNT_EXPORT();
+	auto it = s_Paths.find(name);
+	if (it == s_Paths.end() || point < 0 || point >= static_cast<int>(it->second.size()))
+		return false;
+	it->second[point] = VECTOR_2D(x, z);
+	return true;
+}
+
+bool DLLAPI TerrainIsWater(float x, float z)
+{
+	COUNT_EXPORT_AS("TerrainIsWater(float, float)");
+	return TerrainHeight(x, z) < WATER_HEIGHT;
+}
+
+bool DLLAPI TerrainIsWater(const Vector& pos)
+{
+	COUNT_EXPORT_AS("TerrainIsWater(Vector)");
+	return TerrainHeight(pos.x, pos.z) < WATER_HEIGHT;
+}
+
+bool DLLAPI TerrainGetHeightAndNormal(const Vector& pos, float& outHeight, Vector& outNormal, bool useWater)
+{
+	COUNT_EXPORT();
+	const float half = s_Config.worldSize * 0.5f;
+	if (pos.x < -half || pos.x > half || pos.z < -half || pos.z > half)
+		return false;
+
+	outHeight = TerrainHeight(pos.x, pos.z);
+	if (useWater)
+		outHeight = std::max(outHeight, WATER_HEIGHT);
+
+	const float dx = 40.0f / 300.0f * std::cos(pos.x / 300.0f) * std::cos(pos.z / 250.0f);
+	const float dz = -40.0f / 250.0f * std::sin(pos.x / 300.0f) * std::sin(pos.z / 250.0f);
+	const float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+	outNormal = Vector(-dx / length, 1.0f / length, -dz / length);
+	return true;
+}
+
+float DLLAPI TerrainFindFloor(float x, float z)
+{
+	COUNT_EXPORT();
+	return TerrainHeight(x, z);
+}
+
+float DLLAPI GetTerrainHeight(float x, float z)
+{
+	COUNT_EXPORT();
+	return TerrainHeight(x, z);
+}
+
+const char* DLLAPI GetMapTRNFilename(void)
+{
+	COUNT_EXPORT();
+	return "harness.trn";
+}
+
+// The system temp directory, so files the mission writes don't end up in the tree
+bool DLLAPI GetOutputPath(size_t& bufSize, wchar_t* pData)
+{
+	COUNT_EXPORT();
+	const std::wstring path = (std::filesystem::temp_directory_path() / "").wstring();
+	if (!pData || bufSize < path.size() + 1)
+	{
+		bufSize = path.size() + 1;
+		return false;
+	}
+	std::copy(path.begin(), path.end(), pData);
+	pData[path.size()] = L'\0';
+	return true;
+}
+
+// Teams 1-5 and 6-10 are allied, like team strat
+bool DLLAPI IsTeamAllied(TeamNum t1, TeamNum t2)
+{
+	COUNT_EXPORT();
+	if (t1 == t2)
+		return true;
+	auto group = [](TeamNum t) { return t >= 1 && t <= 5 ? 1 : t >= 6 && t <= 10 ? 2 : 0; };
+	return group(t1) != 0 && group(t1) == group(t2);
+}
+
+// One spawnpoint per team at a fixed spot on a ring, so they never move
+Vector DLLAPI GetSpawnpoint(int TeamNum)
+{
+	COUNT_EXPORT();
+	const float angle = 6.2831853f * TeamNum / MAX_TEAMS;
+	const float radius = s_Config.worldSize * 0.35f;
+	return Vector(radius * std::cos(angle), 0.0f, radius * std::sin(angle));
+}
+
+Vector DLLAPI GetSafestSpawnpoint(void)
+{
+	COUNT_EXPORT();
+	return Vector(0.0f, 0.0f, 0.0f);
+}
+
+Handle DLLAPI GetTarget(Handle h)
+{
+	COUNT_EXPORT();
+	const Object* obj = FindObject(h);
+	return obj ? obj->target : 0;
+}
+
+void DLLAPI SetTarget(Handle obj, Handle target)
+{
+	COUNT_EXPORT();
+	SetObjectTarget(obj, target);
+}
+
+bool DLLAPI WhoIsTargeting(size_t& bufSize, Handle* pData, Handle me)
+{
+	COUNT_EXPORT();
+	auto it = s_TargetedBy.find(me);
+	if (it == s_TargetedBy.end())
+	{
+		bufSize = 0;
+		return true;
+	}
+
+	// Drop the stale entries first so the size asked for is exact
+	std::vector<Handle>& who = it->second;
+	who.erase(std::remove_if(who.begin(), who.end(), [me](Handle h)
+	{
+		const Object* obj = FindObject(h);
+		return !obj || obj->target != me;
+	}), who.end());
+
+	if (!pData || bufSize < who.size())
+	{
+		bufSize = who.size();
+		return false;
+	}
+	std::copy(who.begin(), who.end(), pData);
+	bufSize = who.size();
+	return true;
+}
@@ -0,0 +1,62 @@
+#ifndef _StubRuntime_
+#define _StubRuntime_
+
+#include <ScriptUtils.h>
+
+#include <cstdint>
+#include <span>
+
+// Stand-in for the game side of ScriptUtils.h, so the mission can run
+// headless on Linux. Keeps an in-memory world of synthetic objects that
+// drift around the map, and counts every export the mission calls.
+//
+// Only the exports the mission actually uses are implemented; a new call
+// into the game shows up as a link error in the harness, add a stub for
+// it in StubRuntime.cpp.
+namespace StubRuntime
+{
+	struct Config
+	{
+		int objectCount = 1000;
+		int tps = 20;
+		float worldSize = 4096.0f;
+		uint32_t seed = 1;
+	};
+
+	// Clears the world and fills it with config.objectCount objects.
+	void Init(const Config& config);
+
+	// Advances the lockstep turn and moves every object one turn.
+	void Step();
+
+	// Adds a new random object and returns its handle. The mission isn't
+	// told, call AddObject yourself.
+	Handle SpawnObject();
+
+	// Removes h from the world. Call DeleteObject first, as the game would.
+	void RemoveObject(Handle h);
+
+	// Picks an existing object, or 0 if the world is empty.
+	Handle PickObject();
+
+	std::span<const Handle> GetHandles();
+
+	// Write/Read go to an in-memory buffer. Clear it before a Save and
+	// rewind it before the matching Load.
+	void ClearSave();
+	void RewindSave();
+
+	struct ExportCount
+	{
+		const char* name;
+		uint64_t calls;
+	};
+
+	// Calls per export since the last ResetExportCounts, in the order each
+	// export was first called.
+	std::span<const ExportCount> GetExportCounts();
+	uint64_t GetTotalExportCalls();
+	void ResetExportCounts();
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "TargetingBench.h"
+
+#include "EntityTable.h"
+#include "OrderBuffer.h"
+#include "SpatialGrid.h"
+#include "StubRuntime.h"
+#include "TargetAssigner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+int RunTargetingBenchmark(uint32_t seed)
+{
+	const int SIZES[] = { 10, 50, 100, 250, 500, 1000, 2000 };
+
+	std::printf("%10s %10s %12s %10s %12s %12s %12s\n", "attackers", "enemies", "us/solve", "assigned", "retargeted", "exports", "queries");
+
+	for (int size : SIZES)
+	{
+		// Teams are split three ways in the stub, so this gives about size attackers on team 1
+		StubRuntime::Config config;
+		config.objectCount = size * 3;
+		config.seed = seed;
+		StubRuntime::Init(config);
+
+		EntityTable table;
+		for (Handle h : StubRuntime::GetHandles())
+			table.Add(h);
+		table.Refresh(GetLockstepTurn());
+		SpatialGrid grid;
+		grid.Build(table);
+
+		std::vector<Handle> attackers;
+		std::vector<Handle> enemies;
+		for (size_t i = 0; i < table.Size(); ++i)
+		{
+			if (table.GetTeamNum(i) == 1)
+				attackers.push_back(table.GetHandle(i));
+			else if (table.GetTeamNum(i) == 6)
+				enemies.push_back(table.GetHandle(i));
+		}
+
+		// Half the enemies are already shooting at someone
+		for (size_t i = 0; i < enemies.size() && !attackers.empty(); i += 2)
+			SetTarget(enemies[i], attackers[i % attackers.size()]);
+
+		OrderBuffer orders;
+		TargetAssigner assigner(orders);
+
+		// First solve picks targets from scratch, the timed ones after it mostly keep them
+		assigner.Solve(table, grid, attackers);
+		orders.Flush(GetLockstepTurn());
+		assigner.ResetStats();
+		StubRuntime::ResetExportCounts();
+
+		const int iterations = std::max(5, 20000 / size);
+		size_t assigned = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i)
+			assigned = assigner.Solve(table, grid, attackers);
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		orders.Flush(GetLockstepTurn());
+
+		std::printf("%10zu %10zu %12.1f %10zu %12llu %12.1f %12.1f\n", attackers.size(), enemies.size(),
+			std::chrono::duration<double, std::micro>(elapsed).count() / iterations, assigned,
+			static_cast<unsigned long long>(assigner.GetStats().retargeted),
+			static_cast<double>(StubRuntime::GetTotalExportCalls()) / iterations,
+			static_cast<double>(assigner.GetStats().targetingQueries) / iterations);
+	}
+
+	return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef _TargetingBench_
+#define _TargetingBench_
+
+#include <cstdint>
+
+// Times TargetAssigner::Solve against StubRuntime worlds from 10 to 2000
+// attackers and prints the cost per solve. Reinitializes the stub world.
+int RunTargetingBenchmark(uint32_t seed);
+
+#endif
@@ -0,0 +1,164 @@
+#include "TrigCheck.h"
+
+#include "PortableTrig.h"
+#include "RandomStream.h"
+
+#include <ScriptUtils.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	constexpr float PI = 3.14159265358979f;
+
+	constexpr int TURNS = 10;
+
+	// One turn's inputs for each function
+	struct Turn
+	{
+		std::vector<float> angles;
+		std::vector<float> unit;
+		std::vector<float> x;
+		std::vector<float> y;
+	};
+
+	// Inputs worth trying once, on every function
+	void AddSpecials(std::vector<float>& out)
+	{
+		const float SPECIALS[] = { 0.0f, -0.0f, 1.0f, -1.0f, PI, -PI, 1e-30f, -1e-30f, 1e30f,
+			std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::infinity(),
+			std::numeric_limits<float>::quiet_NaN() };
+		out.insert(out.end(), std::begin(SPECIALS), std::end(SPECIALS));
+	}
+
+	// What placement and steering code asks for in a turn: every slot of
+	// rings of 3 to 32, which are the same every turn, plus fresh headings
+	// and ratios, which never repeat exactly
+	Turn MakeTurn(RandomStream& random)
+	{
+		Turn turn;
+		for (int count = 3; count <= 32; ++count)
+		{
+			for (int slot = 0; slot < count; ++slot)
+				turn.angles.push_back(2.0f * PI * slot / count);
+		}
+		for (int i = 0; i < 512; ++i)
+			turn.angles.push_back(random.Float(-8.0f * PI, 8.0f * PI));
+		AddSpecials(turn.angles);
+
+		for (int i = 0; i < 512; ++i)
+			turn.unit.push_back(random.Float(-1.05f, 1.05f));
+		AddSpecials(turn.unit);
+
+		for (float angle : turn.angles)
+		{
+			const float radius = random.Float(0.5f, 100.0f);
+			turn.x.push_back(std::cos(angle) * radius);
+			turn.y.push_back(std::sin(angle) * radius);
+		}
+		AddSpecials(turn.x);
+		AddSpecials(turn.y);
+		// Both signs of zero together
+		turn.x.push_back(-0.0f);
+		turn.y.push_back(0.0f);
+		return turn;
+	}
+
+	double Microseconds(std::chrono::steady_clock::duration d)
+	{
+		return std::chrono::duration<double, std::micro>(d).count();
+	}
+
+	bool SameBits(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+	}
+
+	// direct(turn, out) fills out calling the exports one by one, batch(turn,
+	// out) through PortableTrig. Every turn's results have to match bit for bit.
+	template <typename Direct, typename Batch>
+	bool Check(const char* name, const std::vector<Turn>& turns, size_t (*size)(const Turn&), Direct&& direct, Batch&& batch)
+	{
+		std::vector<std::vector<float>> expected(turns.size());
+		size_t inputs = 0;
+		const auto directStart = std::chrono::steady_clock::now();
+		for (size_t t = 0; t < turns.size(); ++t)
+		{
+			expected[t].resize(size(turns[t]));
+			inputs += expected[t].size();
+			direct(turns[t], expected[t]);
+		}
+		const auto directTime = std::chrono::steady_clock::now() - directStart;
+
+		std::vector<std::vector<float>> actual(turns.size());
+		const auto batchStart = std::chrono::steady_clock::now();
+		for (size_t t = 0; t < turns.size(); ++t)
+		{
+			actual[t].resize(size(turns[t]));
+			batch(turns[t], actual[t]);
+		}
+		const auto batchTime = std::chrono::steady_clock::now() - batchStart;
+
+		bool same = true;
+		for (size_t t = 0; t < turns.size(); ++t)
+			same &= SameBits(expected[t], actual[t]);
+
+		std::printf("%-8s %8zu %12.1f %12.1f %10s\n", name, inputs,
+			Microseconds(directTime) / turns.size(), Microseconds(batchTime) / turns.size(), same ? "same" : "MISMATCH");
+		return same;
+	}
+}
+
+int RunTrigCheck(uint32_t seed)
+{
+	RandomStream random(seed);
+	std::vector<Turn> turns;
+	for (int t = 0; t < TURNS; ++t)
+		turns.push_back(MakeTurn(random));
+
+	auto angleCount = [](const Turn& turn) { return turn.angles.size(); };
+	auto unitCount = [](const Turn& turn) { return turn.unit.size(); };
+	auto pairCount = [](const Turn& turn) { return turn.x.size(); };
+
+	std::printf("%-8s %8s %12s %12s %10s\n", "function", "inputs", "direct us", "batch us", "result");
+	bool ok = true;
+	ok &= Check("sin", turns, angleCount,
+		[](const Turn& turn, std::vector<float>& out) { for (size_t i = 0; i < out.size(); ++i) out[i] = portable_sin(turn.angles[i]); },
+		[](const Turn& turn, std::vector<float>& out) { PortableTrig::Sin(turn.angles, out); });
+	ok &= Check("cos", turns, angleCount,
+		[](const Turn& turn, std::vector<float>& out) { for (size_t i = 0; i < out.size(); ++i) out[i] = portable_cos(turn.angles[i]); },
+		[](const Turn& turn, std::vector<float>& out) { PortableTrig::Cos(turn.angles, out); });
+	ok &= Check("asin", turns, unitCount,
+		[](const Turn& turn, std::vector<float>& out) { for (size_t i = 0; i < out.size(); ++i) out[i] = portable_asin(turn.unit[i]); },
+		[](const Turn& turn, std::vector<float>& out) { PortableTrig::Asin(turn.unit, out); });
+	ok &= Check("acos", turns, unitCount,
+		[](const Turn& turn, std::vector<float>& out) { for (size_t i = 0; i < out.size(); ++i) out[i] = portable_acos(turn.unit[i]); },
+		[](const Turn& turn, std::vector<float>& out) { PortableTrig::Acos(turn.unit, out); });
+	ok &= Check("atan2", turns, pairCount,
+		[](const Turn& turn, std::vector<float>& out) { for (size_t i = 0; i < out.size(); ++i) out[i] = portable_atan2(turn.x[i], turn.y[i]); },
+		[](const Turn& turn, std::vector<float>& out) { PortableTrig::Atan2(turn.x, turn.y, out); });
+
+	// SinCos has to agree with the separate exports too
+	bool sinCosSame = true;
+	for (const Turn& turn : turns)
+	{
+		std::vector<float> sinOut(turn.angles.size());
+		std::vector<float> cosOut(turn.angles.size());
+		PortableTrig::SinCos(turn.angles, sinOut, cosOut);
+		for (size_t i = 0; i < turn.angles.size(); ++i)
+		{
+			const float s = portable_sin(turn.angles[i]);
+			const float c = portable_cos(turn.angles[i]);
+			sinCosSame &= std::memcmp(&s, &sinOut[i], sizeof(float)) == 0 && std::memcmp(&c, &cosOut[i], sizeof(float)) == 0;
+		}
+	}
+	std::printf("%-8s %43s\n", "sincos", sinCosSame ? "same" : "MISMATCH");
+	ok &= sinCosSame;
+
+	return ok ? 0 : 1;
+}
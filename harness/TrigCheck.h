@@ -0,0 +1,11 @@
+#ifndef _TrigCheck_
+#define _TrigCheck_
+
+#include <cstdint>
+
+// Checks every PortableTrig span function against calling the portable_*
+// exports directly, bit for bit, over sampled inputs, and prints the
+// timing. Returns nonzero on a mismatch.
+int RunTrigCheck(uint32_t seed);
+
+#endif
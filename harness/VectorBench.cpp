@@ -0,0 +1,132 @@
+#include "VectorBench.h"
+
+#include "RandomStream.h"
+#include "VectorMath.h"
+
+#include <ScriptUtils.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Runs fn until it has run for a while. Returns nanoseconds per element.
+	template <typename Fn>
+	double TimePerElement(size_t elements, Fn&& fn)
+	{
+		int repeats = 0;
+		const auto start = Clock::now();
+		auto elapsed = Clock::duration::zero();
+		do
+		{
+			fn();
+			++repeats;
+			elapsed = Clock::now() - start;
+		} while (elapsed < std::chrono::milliseconds(20));
+		return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(repeats) * elements);
+	}
+
+	template <typename T>
+	bool SameBits(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+	}
+
+	Vector RandomVector(RandomStream& random, float range)
+	{
+		return Vector(random.Float(-range, range), random.Float(-range, range), random.Float(-range, range));
+	}
+
+	Quaternion RandomRotation(RandomStream& random)
+	{
+		Quaternion q(random.Float(-1.0f, 1.0f), RandomVector(random, 1.0f));
+		const float length = std::sqrt(q.s * q.s + VectorMath::Dot(q.v, q.v));
+		return Quaternion(q.s / length, Vector(q.v.x / length, q.v.y / length, q.v.z / length));
+	}
+
+	bool Report(const char* name, size_t count, double scalar, double span, bool same)
+	{
+		std::printf("%-16s %8zu %12.2f %12.2f %8.2fx %s\n", name, count, scalar, span, scalar / span, same ? "yes" : "NO");
+		return same;
+	}
+}
+
+int RunVectorBenchmark(uint32_t seed)
+{
+	const size_t SIZES[] = { 16, 256, 4096, 65536 };
+
+	RandomStream random(seed);
+	const Matrix m(
+		VectorMath::Normalize(RandomVector(random, 1.0f)),
+		VectorMath::Normalize(RandomVector(random, 1.0f)),
+		VectorMath::Normalize(RandomVector(random, 1.0f)),
+		RandomVector(random, 2000.0f));
+
+	std::printf("%-16s %8s %12s %12s %9s %s\n", "function", "count", "scalar ns", "span ns", "speedup", "same");
+
+	bool ok = true;
+	for (size_t size : SIZES)
+	{
+		std::vector<Vector> points(size);
+		std::vector<Vector> directions(size);
+		std::vector<Quaternion> from(size);
+		std::vector<Quaternion> to(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			points[i] = RandomVector(random, 2000.0f);
+			directions[i] = RandomVector(random, 50.0f);
+			from[i] = RandomRotation(random);
+			to[i] = RandomRotation(random);
+		}
+		// Zero vectors and nearly parallel rotations take the fallback paths
+		for (size_t i = 0; i < size; i += 7)
+			directions[i] = Vector(0.0f, 0.0f, 0.0f);
+		for (size_t i = 3; i < size; i += 7)
+			to[i] = from[i];
+
+		std::vector<Vector> scalarVectors(size);
+		std::vector<Vector> spanVectors(size);
+		std::vector<Quaternion> scalarRotations(size);
+		std::vector<Quaternion> spanRotations(size);
+
+		const double transformScalar = TimePerElement(size, [&]
+		{
+			for (size_t i = 0; i < size; ++i)
+				scalarVectors[i] = VectorMath::TransformPoint(m, points[i]);
+		});
+		const double transformSpan = TimePerElement(size, [&]
+		{
+			VectorMath::TransformPoints(m, points, spanVectors);
+		});
+		ok &= Report("TransformPoints", size, transformScalar, transformSpan, SameBits(scalarVectors, spanVectors));
+
+		const double normalizeScalar = TimePerElement(size, [&]
+		{
+			for (size_t i = 0; i < size; ++i)
+				scalarVectors[i] = VectorMath::Normalize(directions[i]);
+		});
+		const double normalizeSpan = TimePerElement(size, [&]
+		{
+			VectorMath::Normalize(directions, spanVectors);
+		});
+		ok &= Report("Normalize", size, normalizeScalar, normalizeSpan, SameBits(scalarVectors, spanVectors));
+
+		const double slerpScalar = TimePerElement(size, [&]
+		{
+			for (size_t i = 0; i < size; ++i)
+				scalarRotations[i] = VectorMath::Slerp(from[i], to[i], 0.3f);
+		});
+		const double slerpSpan = TimePerElement(size, [&]
+		{
+			VectorMath::Slerp(from, to, 0.3f, spanRotations);
+		});
+		ok &= Report("Slerp", size, slerpScalar, slerpSpan, SameBits(scalarRotations, spanRotations));
+	}
+
+	return ok ? 0 : 1;
+}
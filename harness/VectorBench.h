@@ -0,0 +1,12 @@
+#ifndef _VectorBench_
+#define _VectorBench_
+
+#include <cstdint>
+
+// Times VectorMath's span functions (SSE where it's available) against
+// calling the scalar function on each element, for TransformPoints,
+// Normalize and Slerp over 16 to 65536 elements, and checks both give the
+// same bits. Returns nonzero on a mismatch.
+int RunVectorBenchmark(uint32_t seed);
+
+#endif
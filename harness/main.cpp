@@ -0,0 +1,273 @@
+// Headless driver for the mission. Loads it the way the game does and pumps
+// Update against StubRuntime's synthetic world, reporting CPU time per tick
+// and how often each export was called, and how often it hit the heap.
+//
+// MissionHarness [--objects N] [--ticks N] [--tps N] [--churn N]
+//                [--save-every N] [--seed N] [--realtime]
+// MissionHarness --bench-targeting | --bench-grid | --bench-vector
+//                | --check-parallel | --check-trig | --check-random [--seed N]
+//
+// The bench/check modes run on their own instead of the simulation:
+// --bench-targeting times the target assignment solver, --bench-grid times
+// SpatialGrid against scanning every object, --bench-vector times the
+// VectorMath span functions against their scalar ones, --check-parallel checks
+// ParallelFor/ParallelReduce give the same bits on any thread count,
+// --check-trig checks PortableTrig against the portable_* exports,
+// --check-random checks RandomStreams repeats, isolates and saves. Checks
+// exit nonzero when they fail.
+
+#include <ScriptUtils.h>
+
+#include "GridBench.h"
+#include "HeapCounter.h"
+#include "ParallelCheck.h"
+#include "RandomCheck.h"
+#include "StubRuntime.h"
+#include "TargetingBench.h"
+#include "TrigCheck.h"
+#include "VectorBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		StubRuntime::Config world;
+		int ticks = 2000;
+		// Objects destroyed and created per tick
+		int churn = 1;
+		// Save/Load/PostLoad round trip every N ticks, 0 for never
+		int saveEvery = 0;
+		// Sleep out the rest of each tick instead of running flat out
+		bool realtime = false;
+		// Set by one of the MODES flags
+		int (*mode)(uint32_t seed) = nullptr;
+	};
+
+	struct Mode
+	{
+		const char* flag;
+		int (*run)(uint32_t seed);
+	};
+
+	const Mode MODES[] = {
+		{ "--bench-targeting", RunTargetingBenchmark },
+		{ "--bench-grid", RunGridBenchmark },
+		{ "--bench-vector", RunVectorBenchmark },
+		{ "--check-parallel", RunParallelCheck },
+		{ "--check-trig", RunTrigCheck },
+		{ "--check-random", RunRandomCheck },
+	};
+
+	void PrintUsage()
+	{
+		std::printf("usage: MissionHarness [--objects N] [--ticks N] [--tps N] [--churn N] [--save-every N] [--seed N] [--realtime]\n");
+		std::printf("       MissionHarness");
+		for (const Mode& mode : MODES)
+			std::printf(" %s%s", &mode == MODES ? "" : "| ", mode.flag);
+		std::printf(" [--seed N]\n");
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			if (std::strcmp(arg, "--realtime") == 0)
+			{
+				options.realtime = true;
+				continue;
+			}
+			const Mode* mode = std::find_if(std::begin(MODES), std::end(MODES), [arg](const Mode& m) { return std::strcmp(arg, m.flag) == 0; });
+			if (mode != std::end(MODES))
+			{
+				options.mode = mode->run;
+				continue;
+			}
+			if (i + 1 >= argc)
+				return false;
+
+			const int value = std::atoi(argv[++i]);
+			if (std::strcmp(arg, "--objects") == 0)
+				options.world.objectCount = value;
+			else if (std::strcmp(arg, "--ticks") == 0)
+				options.ticks = value;
+			else if (std::strcmp(arg, "--tps") == 0)
+				options.world.tps = value;
+			else if (std::strcmp(arg, "--churn") == 0)
+				options.churn = value;
+			else if (std::strcmp(arg, "--save-every") == 0)
+				options.saveEvery = value;
+			else if (std::strcmp(arg, "--seed") == 0)
+				options.world.seed = static_cast<uint32_t>(value);
+			else
+				return false;
+		}
+		return options.world.objectCount >= 0 && options.ticks > 0 && options.world.tps > 0 && options.churn >= 0 && options.saveEvery >= 0;
+	}
+
+	int64_t ThreadCpuNanoseconds()
+	{
+		timespec ts{};
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+	}
+
+	double Microseconds(int64_t nanoseconds)
+	{
+		return nanoseconds / 1000.0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (options.mode)
+		return options.mode(options.world.seed);
+
+	StubRuntime::Init(options.world);
+
+	MisnImport import{};
+	MisnExport* mission = GetMisnAPI(&import);
+
+	// Same order as the game: setup, then every object already on the map
+	const int64_t setupStart = ThreadCpuNanoseconds();
+	mission->InitialSetup();
+	for (Handle h : StubRuntime::GetHandles())
+		mission->AddObject(h);
+	const int64_t setupTime = ThreadCpuNanoseconds() - setupStart;
+	const uint64_t setupCalls = StubRuntime::GetTotalExportCalls();
+	StubRuntime::ResetExportCounts();
+
+	std::vector<int64_t> tickTimes;
+	tickTimes.reserve(options.ticks);
+	std::vector<uint64_t> tickAllocations;
+	tickAllocations.reserve(options.ticks);
+	std::vector<Handle> removed;
+
+	const auto tickLength = std::chrono::nanoseconds(1000000000 / options.world.tps);
+	auto nextTick = std::chrono::steady_clock::now();
+
+	for (int tick = 0; tick < options.ticks; ++tick)
+	{
+		StubRuntime::Step();
+
+		// Pick before timing so the harness's own bookkeeping isn't measured
+		removed.clear();
+		for (int i = 0; i < options.churn; ++i)
+		{
+			const Handle h = StubRuntime::PickObject();
+			if (h != 0 && std::find(removed.begin(), removed.end(), h) == removed.end())
+				removed.push_back(h);
+		}
+
+		const int64_t start = ThreadCpuNanoseconds();
+		const uint64_t allocationsBefore = HeapAllocations();
+
+		// The game seeds the mission at the top of every frame
+		mission->SetRandomSeed(options.world.seed * 2654435761u + static_cast<unsigned long>(tick));
+
+		for (Handle h : removed)
+		{
+			mission->DeleteObject(h);
+			StubRuntime::RemoveObject(h);
+		}
+		for (int i = 0; i < options.churn; ++i)
+			mission->AddObject(StubRuntime::SpawnObject());
+
+		mission->Update();
+
+		if (options.saveEvery > 0 && (tick + 1) % options.saveEvery == 0)
+		{
+			StubRuntime::ClearSave();
+			mission->Save(false);
+			StubRuntime::RewindSave();
+			if (!mission->Load(false) || !mission->PostLoad(false))
+				std::printf("tick %d: Load failed\n", tick);
+		}
+
+		const int64_t elapsed = ThreadCpuNanoseconds() - start;
+		tickAllocations.push_back(HeapAllocations() - allocationsBefore);
+		tickTimes.push_back(elapsed);
+
+		if (options.realtime)
+		{
+			nextTick += tickLength;
+			std::this_thread::sleep_until(nextTick);
+		}
+	}
+
+	// Mission over, as the game does before unloading the DLL
+	mission->PostRun();
+
+	int64_t total = 0;
+	for (int64_t t : tickTimes)
+		total += t;
+	std::vector<int64_t> sorted = tickTimes;
+	std::sort(sorted.begin(), sorted.end());
+	auto percentile = [&sorted](double p)
+	{
+		return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+	};
+
+	std::printf("\n%d objects, %d ticks at %d tps, churn %d/tick\n", options.world.objectCount, options.ticks, options.world.tps, options.churn);
+	std::printf("setup: %.1f us, %llu export calls\n", Microseconds(setupTime), static_cast<unsigned long long>(setupCalls));
+	std::printf("tick cpu (us): mean %.1f  p50 %.1f  p99 %.1f  max %.1f  (budget %.1f)\n",
+		Microseconds(total / options.ticks), Microseconds(percentile(0.50)), Microseconds(percentile(0.99)),
+		Microseconds(sorted.back()), Microseconds(tickLength.count()));
+
+	// The first ticks fill caches and size scratch buffers, the second half should be settled
+	uint64_t allocations = 0;
+	uint64_t settledAllocations = 0;
+	for (size_t i = 0; i < tickAllocations.size(); ++i)
+	{
+		allocations += tickAllocations[i];
+		if (i >= tickAllocations.size() / 2)
+			settledAllocations += tickAllocations[i];
+	}
+	const size_t settledTicks = tickAllocations.size() - tickAllocations.size() / 2;
+	std::printf("heap allocations: %llu (%.1f/tick, %.1f/tick over the second half)\n", static_cast<unsigned long long>(allocations),
+		static_cast<double>(allocations) / options.ticks, settledTicks ? static_cast<double>(settledAllocations) / settledTicks : 0.0);
+
+#ifndef NDEBUG
+	// Nothing spawning and nothing saving, so a settled tick has no business on the heap
+	if (options.churn == 0 && options.saveEvery == 0 && settledAllocations != 0)
+	{
+		std::printf("settled ticks allocated with --churn 0\n");
+		return 1;
+	}
+#endif
+
+	const uint64_t tickCalls = StubRuntime::GetTotalExportCalls();
+	std::printf("export calls: %llu (%.1f/tick)\n", static_cast<unsigned long long>(tickCalls), static_cast<double>(tickCalls) / options.ticks);
+
+	std::vector<StubRuntime::ExportCount> counts(StubRuntime::GetExportCounts().begin(), StubRuntime::GetExportCounts().end());
+	std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) { return a.calls > b.calls; });
+	for (const StubRuntime::ExportCount& count : counts)
+	{
+		if (count.calls > 0)
+			std::printf("  %-28s %12llu  %10.1f/tick\n", count.name, static_cast<unsigned long long>(count.calls), static_cast<double>(count.calls) / options.ticks);
+	}
+
+#ifdef MISSION_PROFILING
+	// Same as typing it in the game console
+	std::printf("\n");
+	mission->ProcessCommand(CalcCRC("dll.profile"));
+#endif
+
+	return 0;
+}
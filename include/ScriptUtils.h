@@ -88,7 +88,12 @@ enum PrePickupPowerupReturnCodes
 	PREPICKUPPOWERUP_ALLOW, // Allow the powerup to be picked up
 };
 
+#ifdef _MSC_VER
 enum PathType;
+#else
+// Other compilers need the underlying type for an opaque enum (headless harness)
+enum PathType : int;
+#endif
 
 #if MISN_INTERNAL
 #include <stdio.h>
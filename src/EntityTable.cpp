@@ -0,0 +1,102 @@
+#include "EntityTable.h"
+
+void EntityTable::Add(Handle h)
+{
+	if (h == 0 || Contains(h))
+		return;
+
+	m_Index.emplace(h, static_cast<uint32_t>(m_Handles.size()));
+
+	m_Handles.push_back(h);
+	m_Positions.emplace_back(0.0f, 0.0f, 0.0f);
+	m_Velocities.emplace_back(0.0f, 0.0f, 0.0f);
+	m_Teams.push_back(0);
+	m_Healths.push_back(0.0f);
+	m_Categories.push_back(::GetCategoryType(h));
+	m_Alive.push_back(0);
+
+	char cfg[64] = {};
+	m_OdfIds.push_back(::GetObjInfo(h, Get_CFG, cfg) ? m_Odfs.Intern(cfg) : INVALID_ODF_ID);
+
+	// Objects added mid-frame would otherwise read as zeroes until the next Refresh
+	Capture(m_Handles.size() - 1);
+}
+
+void EntityTable::Remove(Handle h)
+{
+	auto it = m_Index.find(h);
+	if (it == m_Index.end())
+		return;
+
+	// Swap the last entry into the hole so the arrays stay dense
+	const size_t i = it->second;
+	const size_t last = m_Handles.size() - 1;
+	m_Index.erase(it);
+
+	if (i != last)
+	{
+		m_Handles[i] = m_Handles[last];
+		m_Positions[i] = m_Positions[last];
+		m_Velocities[i] = m_Velocities[last];
+		m_Teams[i] = m_Teams[last];
+		m_Healths[i] = m_Healths[last];
+		m_Categories[i] = m_Categories[last];
+		m_Alive[i] = m_Alive[last];
+		m_OdfIds[i] = m_OdfIds[last];
+
+		m_Index[m_Handles[i]] = static_cast<uint32_t>(i);
+	}
+
+	m_Handles.pop_back();
+	m_Positions.pop_back();
+	m_Velocities.pop_back();
+	m_Teams.pop_back();
+	m_Healths.pop_back();
+	m_Categories.pop_back();
+	m_Alive.pop_back();
+	m_OdfIds.pop_back();
+}
+
+void EntityTable::Clear()
+{
+	m_Handles.clear();
+	m_Positions.clear();
+	m_Velocities.clear();
+	m_Teams.clear();
+	m_Healths.clear();
+	m_Categories.clear();
+	m_Alive.clear();
+	m_OdfIds.clear();
+	m_Index.clear();
+	m_SnapshotTurn = -1;
+}
+
+size_t EntityTable::Select(const OdfSet& set, std::vector<uint32_t>& out) const
+{
+	const size_t before = out.size();
+	for (size_t i = 0; i < m_OdfIds.size(); ++i)
+	{
+		if (set.Contains(m_OdfIds[i]))
+			out.push_back(static_cast<uint32_t>(i));
+	}
+	return out.size() - before;
+}
+
+void EntityTable::Refresh(long turn)
+{
+	for (size_t i = 0; i < m_Handles.size(); ++i)
+		Capture(i);
+
+	m_SnapshotTurn = turn;
+}
+
+void EntityTable::Capture(size_t i)
+{
+	const Handle h = m_Handles[i];
+
+	::GetPosition(h, m_Positions[i]);
+	m_Velocities[i] = ::GetVelocity(h);
+	m_Teams[i] = ::GetTeamNum(h);
+	m_Healths[i] = ::GetHealth(h);
+	m_Alive[i] = ::IsAlive2(h) ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+#ifndef _EntityTable_
+#define _EntityTable_
+
+#include <ScriptUtils.h>
+
+#include "OdfRegistry.h"
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Frame-coherent snapshot of every object the mission has been told about
+// through AddObject/DeleteObject. Data is stored as parallel arrays (one
+// entry per tracked object, same index in every array) so loops over a
+// single field stay cache friendly.
+//
+// Call Refresh(turn) once at the top of Update; after that, mission logic
+// should read positions, teams, etc. out of the table instead of calling
+// GetPosition/GetTeamNum/etc. on the same handles over and over.
+//
+// Indices are only stable until the next Add/Remove, since removal swaps
+// the last entry into the freed slot. Hold on to handles, not indices.
+class EntityTable
+{
+public:
+	// Starts tracking h. Static data (category, config) is captured here,
+	// the rest is captured immediately and then on every Refresh.
+	void Add(Handle h);
+
+	// Stops tracking h. Does nothing if h isn't tracked.
+	void Remove(Handle h);
+
+	void Clear();
+
+	// Captures position, velocity, team, health and alive state for every
+	// tracked object. Call this once per Update, before any mission logic,
+	// with GetLockstepTurn().
+	void Refresh(long turn);
+
+	// Returns the index of h in the table, or -1 if it isn't tracked.
+	int Find(Handle h) const
+	{
+		auto it = m_Index.find(h);
+		return it != m_Index.end() ? static_cast<int>(it->second) : -1;
+	}
+
+	bool Contains(Handle h) const { return m_Index.contains(h); }
+
+	size_t Size() const { return m_Handles.size(); }
+
+	// The lockstep turn the snapshot was last captured on.
+	long GetSnapshotTurn() const { return m_SnapshotTurn; }
+
+	std::span<const Handle> GetHandles() const { return m_Handles; }
+	std::span<const Vector> GetPositions() const { return m_Positions; }
+	std::span<const Vector> GetVelocities() const { return m_Velocities; }
+	std::span<const TeamNum> GetTeams() const { return m_Teams; }
+	std::span<const float> GetHealths() const { return m_Healths; }
+	std::span<const int> GetCategories() const { return m_Categories; }
+	std::span<const uint8_t> GetAlive() const { return m_Alive; }
+	std::span<const OdfId> GetOdfIds() const { return m_OdfIds; }
+
+	Handle GetHandle(size_t i) const { return m_Handles[i]; }
+	const Vector& GetPosition(size_t i) const { return m_Positions[i]; }
+	const Vector& GetVelocity(size_t i) const { return m_Velocities[i]; }
+	TeamNum GetTeamNum(size_t i) const { return m_Teams[i]; }
+	float GetHealth(size_t i) const { return m_Healths[i]; }
+	int GetCategory(size_t i) const { return m_Categories[i]; }
+	bool IsAlive(size_t i) const { return m_Alive[i] != 0; }
+	OdfId GetOdfId(size_t i) const { return m_OdfIds[i]; }
+
+	// Integer compare replacement for IsOdf(h, "ivtank"). Get the id once
+	// with GetOdfRegistry().Intern("ivtank").
+	bool IsOdf(size_t i, OdfId id) const { return m_OdfIds[i] == id; }
+	bool IsOdf(size_t i, const OdfSet& set) const { return set.Contains(m_OdfIds[i]); }
+
+	// Appends the index of every tracked object whose config is in set.
+	// Returns how many were appended.
+	size_t Select(const OdfSet& set, std::vector<uint32_t>& out) const;
+
+	// Config names seen by Add(). Ids survive Clear(), so they can be
+	// interned once at startup and kept.
+	OdfRegistry& GetOdfRegistry() { return m_Odfs; }
+	const OdfRegistry& GetOdfRegistry() const { return m_Odfs; }
+
+private:
+	void Capture(size_t i);
+
+	std::vector<Handle> m_Handles;
+	std::vector<Vector> m_Positions;
+	std::vector<Vector> m_Velocities;
+	std::vector<TeamNum> m_Teams;
+	std::vector<float> m_Healths;
+	std::vector<int> m_Categories;
+	std::vector<uint8_t> m_Alive;
+	std::vector<OdfId> m_OdfIds;
+
+	std::unordered_map<Handle, uint32_t> m_Index;
+
+	OdfRegistry m_Odfs;
+
+	long m_SnapshotTurn = -1;
+};
+
+#endif
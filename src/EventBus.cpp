@@ -0,0 +1,63 @@
+#include "EventBus.h"
+
+#include "Profiler.h"
+
+namespace
+{
+	MissionEventBus* s_Instance = nullptr;
+
+	PreSnipeReturnCodes DLLAPI OnPreSnipe(const int curWorld, Handle shooterHandle, Handle victimHandle, int ordnanceTeam, const char* pOrdnanceODF)
+	{
+		PROFILE_SCOPE(PROFILE_PRE_SNIPE);
+		return s_Instance->PreSnipe.Dispatch(curWorld, shooterHandle, victimHandle, ordnanceTeam, pOrdnanceODF);
+	}
+
+	void DLLAPI OnPreOrdnanceHit(Handle shooterHandle, Handle victimHandle, int ordnanceTeam, const char* pOrdnanceODF)
+	{
+		PROFILE_SCOPE(PROFILE_PRE_ORDNANCE_HIT);
+		s_Instance->PreOrdnanceHit.Dispatch(shooterHandle, victimHandle, ordnanceTeam, pOrdnanceODF);
+	}
+
+	PreGetInReturnCodes DLLAPI OnPreGetIn(const int curWorld, Handle pilotHandle, Handle emptyCraftHandle)
+	{
+		PROFILE_SCOPE(PROFILE_PRE_GET_IN);
+		return s_Instance->PreGetIn.Dispatch(curWorld, pilotHandle, emptyCraftHandle);
+	}
+
+	PrePickupPowerupReturnCodes DLLAPI OnPrePickupPowerup(const int curWorld, Handle me, Handle powerupHandle)
+	{
+		PROFILE_SCOPE(PROFILE_PRE_PICKUP_POWERUP);
+		return s_Instance->PrePickupPowerup.Dispatch(curWorld, me, powerupHandle);
+	}
+
+	void DLLAPI OnPostTargetChanged(Handle craft, Handle previousTarget, Handle currentTarget)
+	{
+		PROFILE_SCOPE(PROFILE_POST_TARGET_CHANGED);
+		s_Instance->PostTargetChanged.Dispatch(craft, previousTarget, currentTarget);
+	}
+
+	void DLLAPI OnChatMessageSent(int senderTeam, long sentTurn, const char* message)
+	{
+		PROFILE_SCOPE(PROFILE_CHAT_MESSAGE_SENT);
+		s_Instance->ChatMessageSent.Dispatch(senderTeam, sentTurn, message);
+	}
+}
+
+MissionEventBus::MissionEventBus()
+	// Defaults are what the game does when no DLL callback is set
+	: PreSnipe([](bool install) { SetPreSnipeCallback(install ? OnPreSnipe : nullptr); }, PRESNIPE_KILLPILOT)
+	, PreOrdnanceHit([](bool install) { SetPreOrdnanceHitCallback(install ? OnPreOrdnanceHit : nullptr); })
+	, PreGetIn([](bool install) { SetPreGetInCallback(install ? OnPreGetIn : nullptr); }, PREGETIN_ALLOW)
+	, PrePickupPowerup([](bool install) { SetPrePickupPowerupCallback(install ? OnPrePickupPowerup : nullptr); }, PREPICKUPPOWERUP_ALLOW)
+	, PostTargetChanged([](bool install) { SetPostTargetChangedCallback(install ? OnPostTargetChanged : nullptr); })
+	, ChatMessageSent([](bool install) { SetChatMessageSentCallback(install ? OnChatMessageSent : nullptr); })
+{
+	s_Instance = this;
+}
+
+MissionEventBus::~MissionEventBus()
+{
+	// The game clears our callbacks itself when the DLL unloads
+	if (s_Instance == this)
+		s_Instance = nullptr;
+}
@@ -0,0 +1,220 @@
+#ifndef _EventBus_
+#define _EventBus_
+
+#include <ScriptUtils.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Identifies one subscription so it can be removed again. 0 is never used.
+typedef uint32_t EventSubscription;
+
+template <typename Signature>
+class EventChannel;
+
+// A list of subscribers for one event, kept sorted by priority (highest
+// first, ties in subscription order) in a flat array. Dispatch walks the
+// array calling plain function pointers, so raising an event never
+// allocates.
+//
+// Subscribers can subscribe/unsubscribe from inside a dispatch. Removals
+// take effect immediately; additions start receiving events from the
+// next dispatch.
+//
+// Events that return a value stop at the first subscriber that returns
+// something other than the channel's default (e.g. the first PreGetIn
+// subscriber to deny entry), and that's what the game gets back.
+template <typename R, typename... Args>
+class EventChannel<R(Args...)>
+{
+public:
+	typedef R (*Callback)(void* context, Args... args);
+	typedef void (*InstallFn)(bool install);
+
+	// Stand-in so void channels can share the constructor; unused for them
+	typedef std::conditional_t<std::is_void_v<R>, int, R> DefaultType;
+
+	// install is called with true when the first subscriber arrives and
+	// false when the last one leaves, so the game only calls into the DLL
+	// for events someone is listening to.
+	explicit EventChannel(InstallFn install = nullptr, DefaultType defaultResult = DefaultType())
+		: m_Install(install), m_Default(defaultResult)
+	{
+	}
+
+	EventChannel(const EventChannel&) = delete;
+	EventChannel& operator=(const EventChannel&) = delete;
+
+	EventSubscription Subscribe(Callback fn, void* context = nullptr, int priority = 0)
+	{
+		if (!fn)
+			return 0;
+
+		const bool wasEmpty = IsEmpty();
+		const Subscriber sub{ fn, context, priority, ++m_LastId };
+		if (m_Dispatching > 0)
+		{
+			m_Pending.push_back(sub);
+			++m_Count;
+		}
+		else
+		{
+			Insert(sub);
+		}
+
+		if (wasEmpty && m_Install)
+			m_Install(true);
+		return sub.id;
+	}
+
+	// Subscribes obj->*Method, e.g. Subscribe<&AiManager::OnHit>(&aiManager).
+	template <auto Method, typename T>
+	EventSubscription Subscribe(T* obj, int priority = 0)
+	{
+		return Subscribe([](void* context, Args... args) -> R
+		{
+			return (static_cast<T*>(context)->*Method)(args...);
+		}, obj, priority);
+	}
+
+	bool Unsubscribe(EventSubscription id)
+	{
+		bool removed = false;
+		for (Subscriber& sub : m_Subscribers)
+		{
+			if (sub.id == id && sub.fn)
+			{
+				// Mid-dispatch, just blank it out and compact afterwards
+				sub.fn = nullptr;
+				removed = true;
+				break;
+			}
+		}
+		if (!removed)
+		{
+			auto it = std::find_if(m_Pending.begin(), m_Pending.end(), [id](const Subscriber& sub) { return sub.id == id; });
+			if (it == m_Pending.end())
+				return false;
+			m_Pending.erase(it);
+		}
+
+		--m_Count;
+		if (m_Dispatching == 0)
+			Compact();
+		if (IsEmpty() && m_Install)
+			m_Install(false);
+		return true;
+	}
+
+	bool IsEmpty() const { return m_Count == 0; }
+	size_t GetSubscriberCount() const { return m_Count; }
+
+	R Dispatch(Args... args)
+	{
+		++m_Dispatching;
+		const size_t count = m_Subscribers.size();
+
+		if constexpr (std::is_void_v<R>)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Subscriber& sub = m_Subscribers[i];
+				if (sub.fn)
+					sub.fn(sub.context, args...);
+			}
+			EndDispatch();
+		}
+		else
+		{
+			R result = m_Default;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Subscriber& sub = m_Subscribers[i];
+				if (!sub.fn)
+					continue;
+				result = sub.fn(sub.context, args...);
+				if (result != m_Default)
+					break;
+			}
+			EndDispatch();
+			return result;
+		}
+	}
+
+private:
+	struct Subscriber
+	{
+		Callback fn;
+		void* context;
+		int priority;
+		EventSubscription id;
+	};
+
+	void Insert(const Subscriber& sub)
+	{
+		auto it = std::upper_bound(m_Subscribers.begin(), m_Subscribers.end(), sub, [](const Subscriber& a, const Subscriber& b)
+		{
+			return a.priority > b.priority;
+		});
+		m_Subscribers.insert(it, sub);
+		++m_Count;
+	}
+
+	void Compact()
+	{
+		std::erase_if(m_Subscribers, [](const Subscriber& sub) { return sub.fn == nullptr; });
+	}
+
+	void EndDispatch()
+	{
+		if (--m_Dispatching > 0)
+			return;
+
+		Compact();
+		// Pending subscribers were already counted, Insert counts them again
+		for (const Subscriber& sub : m_Pending)
+		{
+			--m_Count;
+			Insert(sub);
+		}
+		m_Pending.clear();
+	}
+
+	std::vector<Subscriber> m_Subscribers;
+	std::vector<Subscriber> m_Pending;
+	size_t m_Count = 0;
+	int m_Dispatching = 0;
+	EventSubscription m_LastId = 0;
+	InstallFn m_Install;
+	DefaultType m_Default;
+};
+
+// Fans the MisnExport2 callbacks (PreSnipe, PreOrdnanceHit, etc) out to
+// any number of subscribers, so mission modules don't have to chain the
+// single game callback by hand. Each game callback is installed through
+// its Set*Callback function when its channel gets its first subscriber,
+// and cleared again when the last one leaves.
+//
+// Only one MissionEventBus may exist at a time, since the game callbacks
+// are plain function pointers that need to find it.
+class MissionEventBus
+{
+public:
+	MissionEventBus();
+	~MissionEventBus();
+	MissionEventBus(const MissionEventBus&) = delete;
+	MissionEventBus& operator=(const MissionEventBus&) = delete;
+
+	// Same parameters as the matching *Callback typedefs in ScriptUtils.h, e.g.
+	// eventBus.PreOrdnanceHit.Subscribe(OnHit, &myState, 10);
+	EventChannel<PreSnipeReturnCodes(int curWorld, Handle shooterHandle, Handle victimHandle, int ordnanceTeam, const char* pOrdnanceODF)> PreSnipe;
+	EventChannel<void(Handle shooterHandle, Handle victimHandle, int ordnanceTeam, const char* pOrdnanceODF)> PreOrdnanceHit;
+	EventChannel<PreGetInReturnCodes(int curWorld, Handle pilotHandle, Handle emptyCraftHandle)> PreGetIn;
+	EventChannel<PrePickupPowerupReturnCodes(int curWorld, Handle me, Handle powerupHandle)> PrePickupPowerup;
+	EventChannel<void(Handle craft, Handle previousTarget, Handle currentTarget)> PostTargetChanged;
+	EventChannel<void(int senderTeam, long sentTurn, const char* message)> ChatMessageSent;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "ExportBuffer.h"
+
+static_assert(sizeof(VECTOR_2D) == 2 * sizeof(float), "GetPathPoints writes straight into the VECTOR_2D array");
+
+std::span<const Handle> QueryAllGameObjectHandles(ExportBuffer<Handle>& buffer)
+{
+	return buffer.Query([](size_t& size, Handle* data) { return GetAllGameObjectHandles(size, data); });
+}
+
+std::span<const Handle> QueryWhoIsTargeting(ExportBuffer<Handle>& buffer, Handle me)
+{
+	return buffer.Query([me](size_t& size, Handle* data) { return WhoIsTargeting(size, data, me); });
+}
+
+std::span<const VECTOR_2D> QueryPathPoints(ExportBuffer<VECTOR_2D>& buffer, ConstName path)
+{
+	return buffer.Query([path](size_t& size, VECTOR_2D* data) { return GetPathPoints(path, size, reinterpret_cast<float*>(data)); });
+}
+
+std::wstring_view QueryOutputPath(ExportBuffer<wchar_t>& buffer)
+{
+	// bufSize isn't reliably the string length, so stop at the terminator
+	const std::span<const wchar_t> path = buffer.Query([](size_t& size, wchar_t* data) { return GetOutputPath(size, data); });
+	const std::wstring_view view(path.data(), path.size());
+	return view.substr(0, view.find(L'\0'));
+}
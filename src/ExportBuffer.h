@@ -0,0 +1,68 @@
+#ifndef _ExportBuffer_
+#define _ExportBuffer_
+
+#include <ScriptUtils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Buffer for the exports that fill a caller array, where the documented
+// pattern is a call with no buffer for the size, new[], then a second
+// call. ExportBuffer keeps its array between calls and tries the fill
+// with it first, so once it's big enough every query is one export call
+// and no allocation. When the game asks for more it grows to at least
+// double and tries again.
+//
+// fill is called as fill(size_t& bufSize, T* data) and returns the
+// export's result, e.g.
+//
+//   buffer.Query([me](size_t& size, Handle* data) { return WhoIsTargeting(size, data, me); });
+//
+// The returned span is valid until the next Query on the same buffer.
+template <typename T>
+class ExportBuffer
+{
+public:
+	explicit ExportBuffer(size_t capacity = 0) : m_Data(capacity) {}
+
+	template <typename Fill>
+	std::span<T> Query(Fill&& fill)
+	{
+		size_t size = m_Data.size();
+		if (fill(size, m_Data.empty() ? nullptr : m_Data.data()))
+			return { m_Data.data(), std::min(size, m_Data.size()) };
+
+		// Not there at all (a missing path, say) rather than too small
+		if (size <= m_Data.size())
+			return {};
+
+		m_Data.resize(std::max(size, m_Data.size() * 2));
+		size = m_Data.size();
+		if (!fill(size, m_Data.data()))
+			return {};
+		return { m_Data.data(), std::min(size, m_Data.size()) };
+	}
+
+	size_t GetCapacity() const { return m_Data.size(); }
+
+private:
+	std::vector<T> m_Data;
+};
+
+// The two-call exports through an ExportBuffer each. Keep the buffer
+// around (a member or a global) so its capacity carries over.
+
+std::span<const Handle> QueryAllGameObjectHandles(ExportBuffer<Handle>& buffer);
+
+std::span<const Handle> QueryWhoIsTargeting(ExportBuffer<Handle>& buffer, Handle me);
+
+// Empty if the path doesn't exist
+std::span<const VECTOR_2D> QueryPathPoints(ExportBuffer<VECTOR_2D>& buffer, ConstName path);
+
+// Without the terminator, empty on failure
+std::wstring_view QueryOutputPath(ExportBuffer<wchar_t>& buffer);
+
+#endif
@@ -0,0 +1,107 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+namespace
+{
+	constexpr size_t BLOCK_ALIGNMENT = alignof(std::max_align_t);
+
+	uintptr_t AlignUp(uintptr_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+
+	uint8_t* NewBlock(size_t size)
+	{
+		return static_cast<uint8_t*>(::operator new(size, std::align_val_t{ BLOCK_ALIGNMENT }));
+	}
+
+	void DeleteBlock(void* block)
+	{
+		::operator delete(block, std::align_val_t{ BLOCK_ALIGNMENT });
+	}
+}
+
+FrameArena::FrameArena(size_t capacity)
+	: m_Capacity(std::max<size_t>(capacity, BLOCK_ALIGNMENT))
+{
+	// The first block is taken on first use, so unused arenas cost nothing
+}
+
+FrameArena::~FrameArena()
+{
+	while (m_Overflow)
+	{
+		Overflow* next = m_Overflow->next;
+		DeleteBlock(m_Overflow);
+		m_Overflow = next;
+	}
+	DeleteBlock(m_Block);
+}
+
+void FrameArena::Reset()
+{
+	const size_t used = GetUsed();
+	++m_Stats.frames;
+	m_Stats.peak = std::max(m_Stats.peak, used);
+	if (m_GrewThisFrame)
+		++m_Stats.growthFrames;
+	m_GrewThisFrame = false;
+
+	// Ran over: one block for the whole frame next time, with room to spare
+	if (m_Overflow)
+	{
+		while (m_Overflow)
+		{
+			Overflow* next = m_Overflow->next;
+			DeleteBlock(m_Overflow);
+			m_Overflow = next;
+		}
+		DeleteBlock(m_Block);
+		m_Block = nullptr;
+		m_Capacity = std::max(m_Capacity, std::bit_ceil(used + used / 2));
+	}
+
+	m_Used = 0;
+	m_OverflowUsed = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+	if (!m_Block)
+	{
+		m_Block = NewBlock(m_Capacity);
+		++m_Stats.heapBlocks;
+		m_GrewThisFrame = true;
+	}
+
+	const uintptr_t base = reinterpret_cast<uintptr_t>(m_Block);
+	const size_t offset = AlignUp(base + m_Used, alignment) - base;
+	if (offset + bytes <= m_Capacity)
+	{
+		m_Used = offset + bytes;
+		return m_Block + offset;
+	}
+
+	return AllocateOverflow(bytes, alignment);
+}
+
+void* FrameArena::AllocateOverflow(size_t bytes, size_t alignment)
+{
+	// Own block per request, sized so the next Reset can count it
+	const size_t header = AlignUp(sizeof(Overflow), std::max(alignment, BLOCK_ALIGNMENT));
+	const size_t size = header + bytes + (alignment > BLOCK_ALIGNMENT ? alignment : 0);
+	uint8_t* block = NewBlock(size);
+	++m_Stats.heapBlocks;
+	m_GrewThisFrame = true;
+
+	Overflow* overflow = reinterpret_cast<Overflow*>(block);
+	overflow->next = m_Overflow;
+	m_Overflow = overflow;
+	m_OverflowUsed += AlignUp(bytes, BLOCK_ALIGNMENT);
+
+	const uintptr_t start = reinterpret_cast<uintptr_t>(block + header);
+	return reinterpret_cast<void*>(AlignUp(start, alignment));
+}
@@ -0,0 +1,87 @@
+#ifndef _FrameArena_
+#define _FrameArena_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Bump allocator for buffers that only live until the end of the current
+// Update: handle lists from the two-call exports, query results, scratch
+// strings. Reset at the top of Update hands all of it back at once.
+//
+// Use it through the pmr containers:
+//
+//   FrameVector<Handle> handles{ &frameArena };
+//
+// Memory comes out of one block. A frame that runs past it takes extra
+// blocks from the heap, and the next Reset swaps them all for a single
+// block big enough for that frame. Once the biggest frame has been seen,
+// ticks don't touch the heap at all. GetStats counts the heap blocks
+// taken, so that's easy to check.
+//
+// Deallocate is a no-op, so don't use it for anything that grows all
+// frame long. Main thread only.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+	explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+	~FrameArena();
+
+	// Frees everything allocated since the last Reset. Call at the top of
+	// Update, when nothing from the last frame is still around.
+	void Reset();
+
+	size_t GetCapacity() const { return m_Capacity; }
+
+	// Bytes handed out this frame, alignment padding included
+	size_t GetUsed() const { return m_Used + m_OverflowUsed; }
+
+	struct Stats
+	{
+		uint64_t frames;
+		// Blocks taken from the heap, the first one included
+		uint64_t heapBlocks;
+		// Frames that needed one
+		uint64_t growthFrames;
+		size_t peak;
+	};
+
+	const Stats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = {}; }
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	// Extra heap block, chained through its own first bytes
+	struct Overflow
+	{
+		Overflow* next;
+	};
+
+	void* AllocateOverflow(size_t bytes, size_t alignment);
+
+	uint8_t* m_Block = nullptr;
+	size_t m_Capacity = 0;
+	size_t m_Used = 0;
+
+	Overflow* m_Overflow = nullptr;
+	size_t m_OverflowUsed = 0;
+
+	Stats m_Stats{};
+	bool m_GrewThisFrame = false;
+};
+
+template <typename T>
+using FrameVector = std::pmr::vector<T>;
+
+using FrameString = std::pmr::string;
+
+#endif
@@ -0,0 +1,395 @@
+#include "InfluenceMap.h"
+
+#include "EntityTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Health changes smaller than this don't restamp an object
+	constexpr float STRENGTH_EPSILON = 0.05f;
+
+	// Close enough for the smoothed value to snap to the stamped one
+	constexpr float SETTLE_EPSILON = 0.001f;
+}
+
+void InfluenceMap::Init(float minX, float minZ, float maxX, float maxZ, float cellSize)
+{
+	// Keep the cell count sane even if the bounds or cell size are garbage
+	constexpr int MAX_CELLS_PER_AXIS = 256;
+
+	m_MinX = minX;
+	m_MinZ = minZ;
+	m_CellSize = cellSize > 1.0f ? cellSize : 1.0f;
+	m_InvCellSize = 1.0f / m_CellSize;
+	m_CellsX = std::clamp(static_cast<int>(std::ceil((maxX - minX) * m_InvCellSize)), 1, MAX_CELLS_PER_AXIS);
+	m_CellsZ = std::clamp(static_cast<int>(std::ceil((maxZ - minZ) * m_InvCellSize)), 1, MAX_CELLS_PER_AXIS);
+	m_CellCount = static_cast<size_t>(m_CellsX) * m_CellsZ;
+
+	m_Raw.assign(m_CellCount * MAX_TEAMS, 0.0f);
+	m_Smoothed.assign(m_CellCount * MAX_TEAMS, 0.0f);
+	m_IsActive.assign(m_CellCount * MAX_TEAMS, 0);
+	m_Active.clear();
+	m_Stamps.clear();
+
+	for (int dz = -STAMP_RADIUS; dz <= STAMP_RADIUS; ++dz)
+	{
+		for (int dx = -STAMP_RADIUS; dx <= STAMP_RADIUS; ++dx)
+		{
+			const float distance = std::sqrt(static_cast<float>(dx * dx + dz * dz));
+			m_Kernel[(dz + STAMP_RADIUS) * (2 * STAMP_RADIUS + 1) + dx + STAMP_RADIUS] = std::max(0.0f, 1.0f - distance / (STAMP_RADIUS + 1));
+		}
+	}
+}
+
+void InfluenceMap::InitFromTerrain(float cellSize)
+{
+	Init(GetTerrainMinX(), GetTerrainMinZ(), GetTerrainMaxX(), GetTerrainMaxZ(), cellSize);
+}
+
+void InfluenceMap::Update(const EntityTable& table)
+{
+	if (!IsInitialized())
+		InitFromTerrain();
+
+	++m_Generation;
+
+	const auto handles = table.GetHandles();
+	const auto positions = table.GetPositions();
+	const auto teams = table.GetTeams();
+	const auto healths = table.GetHealths();
+	const auto alive = table.GetAlive();
+
+	for (size_t i = 0; i < handles.size(); ++i)
+	{
+		// Dead or out of range objects are left unseen, so the sweep below unstamps them
+		if (!alive[i] || teams[i] < 0 || teams[i] >= MAX_TEAMS)
+			continue;
+
+		const uint32_t cell = CellOf(positions[i]);
+		const float strength = std::clamp(healths[i], 0.0f, 1.0f);
+
+		auto [it, inserted] = m_Stamps.try_emplace(handles[i]);
+		Stamp& stamp = it->second;
+		stamp.seen = m_Generation;
+		if (!inserted && stamp.cell == cell && stamp.team == teams[i] && std::abs(stamp.strength - strength) < STRENGTH_EPSILON)
+			continue;
+
+		if (!inserted)
+			Apply(stamp.team, stamp.cell, -stamp.strength);
+		stamp = { cell, teams[i], strength, m_Generation };
+		Apply(stamp.team, stamp.cell, stamp.strength);
+	}
+
+	for (auto it = m_Stamps.begin(); it != m_Stamps.end();)
+	{
+		if (it->second.seen != m_Generation)
+		{
+			Apply(it->second.team, it->second.cell, -it->second.strength);
+			it = m_Stamps.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// Ease the touched cells, dropping the ones that have settled
+	size_t kept = 0;
+	for (uint32_t index : m_Active)
+	{
+		const float gap = m_Raw[index] - m_Smoothed[index];
+		if (std::abs(gap) < SETTLE_EPSILON)
+		{
+			// Stamping and unstamping can leave float dust behind
+			if (std::abs(m_Raw[index]) < SETTLE_EPSILON)
+				m_Raw[index] = 0.0f;
+			m_Smoothed[index] = m_Raw[index];
+			m_IsActive[index] = 0;
+			continue;
+		}
+		m_Smoothed[index] += gap * m_Damping;
+		m_Active[kept++] = index;
+	}
+	m_Active.resize(kept);
+}
+
+void InfluenceMap::Clear()
+{
+	if (IsInitialized())
+		Init(m_MinX, m_MinZ, m_MinX + m_CellsX * m_CellSize, m_MinZ + m_CellsZ * m_CellSize, m_CellSize);
+}
+
+float InfluenceMap::GetInfluence(TeamNum team, const Vector& pos) const
+{
+	if (!IsInitialized() || team < 0 || team >= MAX_TEAMS)
+		return 0.0f;
+	return m_Smoothed[team * m_CellCount + CellOf(pos)];
+}
+
+float InfluenceMap::GetFriendly(TeamNum team, const Vector& pos)
+{
+	if (!IsInitialized())
+		return 0.0f;
+	return Friendly(GetAllyMask(team), CellOf(pos));
+}
+
+float InfluenceMap::GetThreat(TeamNum team, const Vector& pos)
+{
+	if (!IsInitialized())
+		return 0.0f;
+	return Enemy(GetAllyMask(team), CellOf(pos));
+}
+
+size_t InfluenceMap::FindFrontline(TeamNum team, float minInfluence, std::vector<Vector>& out)
+{
+	if (!IsInitialized())
+		return 0;
+
+	const uint32_t mask = GetAllyMask(team);
+	std::pmr::vector<float> friendly(m_CellCount, m_Scratch);
+	std::pmr::vector<float> enemy(m_CellCount, m_Scratch);
+	for (uint32_t cell = 0; cell < m_CellCount; ++cell)
+	{
+		friendly[cell] = Friendly(mask, cell);
+		enemy[cell] = Enemy(mask, cell);
+	}
+
+	auto contested = [&](uint32_t cell)
+	{
+		return friendly[cell] >= minInfluence || enemy[cell] >= minInfluence;
+	};
+
+	const size_t before = out.size();
+	for (int z = 0; z < m_CellsZ; ++z)
+	{
+		for (int x = 0; x < m_CellsX; ++x)
+		{
+			const uint32_t cell = z * m_CellsX + x;
+			if (!contested(cell))
+				continue;
+
+			const bool ours = friendly[cell] >= enemy[cell];
+			const int NX[4] = { x - 1, x + 1, x, x };
+			const int NZ[4] = { z, z, z - 1, z + 1 };
+			for (int k = 0; k < 4; ++k)
+			{
+				if (NX[k] < 0 || NZ[k] < 0 || NX[k] >= m_CellsX || NZ[k] >= m_CellsZ)
+					continue;
+				const uint32_t next = NZ[k] * m_CellsX + NX[k];
+				if (contested(next) && (friendly[next] >= enemy[next]) != ours)
+				{
+					out.push_back(CellCenter(cell));
+					break;
+				}
+			}
+		}
+	}
+	return out.size() - before;
+}
+
+Vector InfluenceMap::FindSafest(TeamNum team, const Vector& near, float radius)
+{
+	if (!IsInitialized())
+		return near;
+
+	const uint32_t mask = GetAllyMask(team);
+	const int x0 = CellX(near.x - radius);
+	const int x1 = CellX(near.x + radius);
+	const int z0 = CellZ(near.z - radius);
+	const int z1 = CellZ(near.z + radius);
+
+	uint32_t best = CellOf(near);
+	float bestThreat = Enemy(mask, best);
+	const Vector nearCenter = CellCenter(best);
+	float bestDistSq = (nearCenter.x - near.x) * (nearCenter.x - near.x) + (nearCenter.z - near.z) * (nearCenter.z - near.z);
+	for (int z = z0; z <= z1; ++z)
+	{
+		for (int x = x0; x <= x1; ++x)
+		{
+			const uint32_t cell = z * m_CellsX + x;
+			const Vector center = CellCenter(cell);
+			const float distSq = (center.x - near.x) * (center.x - near.x) + (center.z - near.z) * (center.z - near.z);
+			if (distSq > radius * radius)
+				continue;
+
+			const float threat = Enemy(mask, cell);
+			if (threat < bestThreat || (threat == bestThreat && distSq < bestDistSq))
+			{
+				best = cell;
+				bestThreat = threat;
+				bestDistSq = distSq;
+			}
+		}
+	}
+	return CellCenter(best);
+}
+
+Vector InfluenceMap::FindStrongestEnemy(TeamNum team, float* influence)
+{
+	if (!IsInitialized())
+	{
+		if (influence)
+			*influence = 0.0f;
+		return Vector(0.0f, 0.0f, 0.0f);
+	}
+
+	const uint32_t mask = GetAllyMask(team);
+	uint32_t best = 0;
+	float bestThreat = -1.0f;
+	for (uint32_t cell = 0; cell < m_CellCount; ++cell)
+	{
+		const float threat = Enemy(mask, cell);
+		if (threat > bestThreat)
+		{
+			best = cell;
+			bestThreat = threat;
+		}
+	}
+
+	if (influence)
+		*influence = bestThreat;
+	return CellCenter(best);
+}
+
+Vector InfluenceMap::PickSpawnpoint(TeamNum team, std::span<const Vector> candidates)
+{
+	if (candidates.empty() || !IsInitialized())
+		return GetSafestSpawnpoint();
+
+	const uint32_t mask = GetAllyMask(team);
+	const Vector* best = nullptr;
+	float bestThreat = std::numeric_limits<float>::infinity();
+	float bestFriendly = 0.0f;
+	for (const Vector& candidate : candidates)
+	{
+		const uint32_t cell = CellOf(candidate);
+		const float threat = Enemy(mask, cell);
+		const float friendly = Friendly(mask, cell);
+		if (threat < bestThreat || (threat == bestThreat && friendly > bestFriendly))
+		{
+			best = &candidate;
+			bestThreat = threat;
+			bestFriendly = friendly;
+		}
+	}
+	return *best;
+}
+
+Vector InfluenceMap::PickSpawnpoint(TeamNum team)
+{
+	// Spawnpoints don't move, ask once
+	if (!m_SpawnpointsFound)
+	{
+		m_SpawnpointsFound = true;
+		for (int t = 0; t < MAX_TEAMS; ++t)
+		{
+			// Teams without one get the safest spawnpoint back, skip repeats and the null vector
+			const Vector pos = GetSpawnpoint(t);
+			if (pos.x == 0.0f && pos.y == 0.0f && pos.z == 0.0f)
+				continue;
+			const bool seen = std::any_of(m_Spawnpoints.begin(), m_Spawnpoints.end(), [&](const Vector& other)
+			{
+				return other.x == pos.x && other.y == pos.y && other.z == pos.z;
+			});
+			if (!seen)
+				m_Spawnpoints.push_back(pos);
+		}
+	}
+	return PickSpawnpoint(team, m_Spawnpoints);
+}
+
+int InfluenceMap::CellX(float x) const
+{
+	return std::clamp(static_cast<int>(std::floor((x - m_MinX) * m_InvCellSize)), 0, m_CellsX - 1);
+}
+
+int InfluenceMap::CellZ(float z) const
+{
+	return std::clamp(static_cast<int>(std::floor((z - m_MinZ) * m_InvCellSize)), 0, m_CellsZ - 1);
+}
+
+Vector InfluenceMap::CellCenter(uint32_t cell) const
+{
+	const int x = cell % m_CellsX;
+	const int z = cell / m_CellsX;
+	return Vector(m_MinX + (x + 0.5f) * m_CellSize, 0.0f, m_MinZ + (z + 0.5f) * m_CellSize);
+}
+
+void InfluenceMap::Apply(TeamNum team, uint32_t cell, float amount)
+{
+	if (amount == 0.0f)
+		return;
+
+	const int cx = cell % m_CellsX;
+	const int cz = cell / m_CellsX;
+	float* layer = m_Raw.data() + team * m_CellCount;
+	for (int dz = -STAMP_RADIUS; dz <= STAMP_RADIUS; ++dz)
+	{
+		const int z = cz + dz;
+		if (z < 0 || z >= m_CellsZ)
+			continue;
+		for (int dx = -STAMP_RADIUS; dx <= STAMP_RADIUS; ++dx)
+		{
+			const int x = cx + dx;
+			const float weight = m_Kernel[(dz + STAMP_RADIUS) * (2 * STAMP_RADIUS + 1) + dx + STAMP_RADIUS];
+			if (x < 0 || x >= m_CellsX || weight == 0.0f)
+				continue;
+
+			const uint32_t target = z * m_CellsX + x;
+			layer[target] += amount * weight;
+
+			const uint32_t index = static_cast<uint32_t>(team * m_CellCount + target);
+			if (!m_IsActive[index])
+			{
+				m_IsActive[index] = 1;
+				m_Active.push_back(index);
+			}
+		}
+	}
+}
+
+uint32_t InfluenceMap::GetAllyMask(TeamNum team)
+{
+	if (team < 0 || team >= MAX_TEAMS)
+		return 0;
+
+	// Alliances can change mid-game, but not often enough to ask more than once a turn
+	if (m_AllyGeneration[team] != m_Generation || m_Generation == 0)
+	{
+		uint32_t mask = 1u << team;
+		for (int t = 1; t < MAX_TEAMS; ++t)
+		{
+			if (t != team && IsTeamAllied(team, t))
+				mask |= 1u << t;
+		}
+		m_AllyMasks[team] = mask;
+		m_AllyGeneration[team] = m_Generation;
+	}
+	return m_AllyMasks[team];
+}
+
+float InfluenceMap::Friendly(uint32_t mask, uint32_t cell) const
+{
+	float sum = 0.0f;
+	for (int t = 0; t < MAX_TEAMS; ++t)
+	{
+		if (mask & (1u << t))
+			sum += m_Smoothed[t * m_CellCount + cell];
+	}
+	return sum;
+}
+
+float InfluenceMap::Enemy(uint32_t mask, uint32_t cell) const
+{
+	// Team 0 is nobody's enemy
+	float sum = 0.0f;
+	for (int t = 1; t < MAX_TEAMS; ++t)
+	{
+		if (!(mask & (1u << t)))
+			sum += m_Smoothed[t * m_CellCount + cell];
+	}
+	return sum;
+}
@@ -0,0 +1,138 @@
+#ifndef _InfluenceMap_
+#define _InfluenceMap_
+
+#include <ScriptUtils.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class EntityTable;
+
+// Coarse per-team influence over the XZ plane, for whole-map AI decisions
+// that CountThreats/GetNearestEnemy can only answer one unit at a time.
+//
+// Every live object spreads its health (0 to 1) over the cells around it
+// with a linear falloff. Update only restamps objects that changed cell,
+// team or health since the last turn, and the values queries see ease
+// toward the stamped ones over a few turns instead of jumping, so only
+// cells near something that moved do any work.
+//
+// "Friendly" for a team is itself plus its allies (IsTeamAllied),
+// "enemy" is everyone else except team 0.
+class InfluenceMap
+{
+public:
+	static constexpr float DEFAULT_CELL_SIZE = 128.0f;
+
+	// Query buffers come out of scratch, e.g. the mission's FrameArena
+	explicit InfluenceMap(std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) : m_Scratch(scratch) {}
+
+	// Lays the cells out over the given XZ bounds. Clears everything.
+	void Init(float minX, float minZ, float maxX, float maxZ, float cellSize = DEFAULT_CELL_SIZE);
+
+	// Same as Init, using GetTerrainMinX/MaxX/MinZ/MaxZ for the bounds.
+	void InitFromTerrain(float cellSize = DEFAULT_CELL_SIZE);
+
+	bool IsInitialized() const { return !m_Raw.empty(); }
+
+	// Fraction of the remaining gap closed each Update, 1 for no easing.
+	void SetDamping(float rate) { m_Damping = rate; }
+
+	// Restamps whatever changed in the table. Call once per Update after
+	// the EntityTable refresh. Lays the cells out over the terrain if Init
+	// hasn't been called yet.
+	void Update(const EntityTable& table);
+
+	// Forgets every object. Call from PostLoad since handles change.
+	void Clear();
+
+	float GetInfluence(TeamNum team, const Vector& pos) const;
+	float GetFriendly(TeamNum team, const Vector& pos);
+	float GetThreat(TeamNum team, const Vector& pos);
+
+	// Centres of cells where team's side and the enemy meet: the balance
+	// (friendly minus enemy) changes sign between neighbours that both
+	// have at least minInfluence from each side nearby.
+	size_t FindFrontline(TeamNum team, float minInfluence, std::vector<Vector>& out);
+
+	// Centre of the cell within radius of near with the least enemy
+	// influence, closest first on ties.
+	Vector FindSafest(TeamNum team, const Vector& near, float radius);
+
+	// Centre of the cell with the most enemy influence, and how much.
+	Vector FindStrongestEnemy(TeamNum team, float* influence = nullptr);
+
+	// The candidate with the least enemy influence, most friendly on ties.
+	// Returns GetSafestSpawnpoint() if candidates is empty.
+	Vector PickSpawnpoint(TeamNum team, std::span<const Vector> candidates);
+
+	// Same, over every team's GetSpawnpoint.
+	Vector PickSpawnpoint(TeamNum team);
+
+	float GetCellSize() const { return m_CellSize; }
+	int GetCellsX() const { return m_CellsX; }
+	int GetCellsZ() const { return m_CellsZ; }
+
+private:
+	// Each object spreads over a square this many cells out from its own
+	static constexpr int STAMP_RADIUS = 2;
+
+	struct Stamp
+	{
+		uint32_t cell;
+		TeamNum team;
+		float strength;
+		uint32_t seen;
+	};
+
+	int CellX(float x) const;
+	int CellZ(float z) const;
+	uint32_t CellOf(const Vector& pos) const { return CellZ(pos.z) * m_CellsX + CellX(pos.x); }
+	Vector CellCenter(uint32_t cell) const;
+
+	// Adds amount of the falloff around cell to team's layer
+	void Apply(TeamNum team, uint32_t cell, float amount);
+
+	// Bit t set if team t counts as friendly to team
+	uint32_t GetAllyMask(TeamNum team);
+
+	float Friendly(uint32_t mask, uint32_t cell) const;
+	float Enemy(uint32_t mask, uint32_t cell) const;
+
+	std::pmr::memory_resource* m_Scratch;
+
+	float m_MinX = 0.0f;
+	float m_MinZ = 0.0f;
+	float m_CellSize = DEFAULT_CELL_SIZE;
+	float m_InvCellSize = 1.0f / DEFAULT_CELL_SIZE;
+	int m_CellsX = 0;
+	int m_CellsZ = 0;
+	size_t m_CellCount = 0;
+
+	float m_Damping = 0.25f;
+
+	// MAX_TEAMS layers of m_CellCount each. m_Raw is what's stamped,
+	// m_Smoothed eases toward it and is what queries read.
+	std::vector<float> m_Raw;
+	std::vector<float> m_Smoothed;
+
+	// Layer cells where m_Smoothed hasn't caught up with m_Raw yet
+	std::vector<uint32_t> m_Active;
+	std::vector<uint8_t> m_IsActive;
+
+	std::unordered_map<Handle, Stamp> m_Stamps;
+	uint32_t m_Generation = 0;
+
+	float m_Kernel[(2 * STAMP_RADIUS + 1) * (2 * STAMP_RADIUS + 1)];
+
+	uint32_t m_AllyMasks[MAX_TEAMS] = {};
+	uint32_t m_AllyGeneration[MAX_TEAMS] = {};
+
+	std::vector<Vector> m_Spawnpoints;
+	bool m_SpawnpointsFound = false;
+};
+
+#endif
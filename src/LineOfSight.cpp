@@ -0,0 +1,185 @@
+#include "LineOfSight.h"
+
+#include "TerrainCache.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define LINEOFSIGHT_SSE 1
+#include <emmintrin.h>
+#else
+#define LINEOFSIGHT_SSE 0
+#endif
+
+namespace
+{
+	constexpr int CACHE_BITS = 12;
+	constexpr size_t CACHE_SIZE = size_t(1) << CACHE_BITS;
+
+	// Samples per terrain cell along a ray. The heightfield is bilinear, so
+	// two a cell rarely misses a ridge.
+	constexpr float SAMPLES_PER_CELL = 2.0f;
+
+	constexpr int32_t EMPTY_TURN = INT32_MIN;
+
+	// Cache cell coordinates of both ends, 16 bits each
+	uint64_t MakeKey(const Vector& from, const Vector& to, float invCellSize)
+	{
+		auto cell = [invCellSize](float v) { return static_cast<uint64_t>(static_cast<uint16_t>(static_cast<int>(std::floor(v * invCellSize)))); };
+		return cell(from.x) | (cell(from.z) << 16) | (cell(to.x) << 32) | (cell(to.z) << 48);
+	}
+
+	size_t Slot(uint64_t key)
+	{
+		return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - CACHE_BITS));
+	}
+}
+
+LineOfSight::LineOfSight(const TerrainCache& terrain)
+	: m_Terrain(terrain)
+	, m_Cache(CACHE_SIZE)
+{
+	Clear();
+}
+
+void LineOfSight::SetHeights(float eyeHeight, float targetHeight)
+{
+	m_EyeHeight = eyeHeight;
+	m_TargetHeight = targetHeight;
+	Clear();
+}
+
+void LineOfSight::SetCacheCellSize(float meters)
+{
+	if (meters > 0.0f)
+		m_InvCacheCellSize = 1.0f / meters;
+	Clear();
+}
+
+bool LineOfSight::CanSee(const Vector& from, const Vector& to)
+{
+	return Lookup(from, to);
+}
+
+void LineOfSight::CanSee(std::span<const LosQuery> queries, std::span<uint8_t> visible)
+{
+	for (size_t i = 0; i < queries.size(); ++i)
+		visible[i] = Lookup(queries[i].from, queries[i].to);
+}
+
+void LineOfSight::Clear()
+{
+	std::fill(m_Cache.begin(), m_Cache.end(), Entry{ 0, EMPTY_TURN, 0 });
+}
+
+bool LineOfSight::Lookup(const Vector& from, const Vector& to)
+{
+	++m_Stats.queries;
+	if (!m_Terrain.IsLoaded())
+		return true;
+	if (m_CacheTurns <= 0 || m_Turn < 0)
+		return Trace(from, to);
+
+	const long turn = m_Turn;
+	const uint64_t key = MakeKey(from, to, m_InvCacheCellSize);
+	Entry& entry = m_Cache[Slot(key)];
+	if (entry.key == key && entry.turn != EMPTY_TURN && turn >= entry.turn && turn - entry.turn < m_CacheTurns)
+	{
+		++m_Stats.cacheHits;
+		return entry.visible != 0;
+	}
+
+	const bool visible = Trace(from, to);
+	entry = { key, static_cast<int32_t>(turn), static_cast<uint8_t>(visible) };
+	return visible;
+}
+
+bool LineOfSight::Trace(const Vector& from, const Vector& to)
+{
+	const float fromY = from.y + m_EyeHeight;
+	const float dx = to.x - from.x;
+	const float dy = (to.y + m_TargetHeight) - fromY;
+	const float dz = to.z - from.z;
+
+	// Ends are left out, they're where the eye and target are
+	const float length = std::sqrt(dx * dx + dz * dz);
+	const int steps = static_cast<int>(length * SAMPLES_PER_CELL / m_Terrain.GetCellSize());
+	if (steps < 2)
+		return true;
+	const float invSteps = 1.0f / static_cast<float>(steps);
+	m_Stats.samples += steps - 1;
+
+	int i = 1;
+
+#if LINEOFSIGHT_SSE
+	const float* heights = m_Terrain.GetSamples().data();
+	const int samplesX = m_Terrain.GetSamplesX();
+	const int samplesZ = m_Terrain.GetSamplesZ();
+
+	// Same math as TerrainCache::GetHeight, four points along the ray at a time
+	const __m128 minX = _mm_set1_ps(m_Terrain.GetMinX());
+	const __m128 minZ = _mm_set1_ps(m_Terrain.GetMinZ());
+	const __m128 invCell = _mm_set1_ps(1.0f / m_Terrain.GetCellSize());
+	const __m128 maxFx = _mm_set1_ps(static_cast<float>(samplesX - 1));
+	const __m128 maxFz = _mm_set1_ps(static_cast<float>(samplesZ - 1));
+	const __m128i maxIx = _mm_set1_epi32(samplesX - 2);
+	const __m128i maxIz = _mm_set1_epi32(samplesZ - 2);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	for (; i + 3 < steps; i += 4)
+	{
+		const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lane), _mm_set1_ps(invSteps));
+		const __m128 x = _mm_add_ps(_mm_set1_ps(from.x), _mm_mul_ps(_mm_set1_ps(dx), t));
+		const __m128 y = _mm_add_ps(_mm_set1_ps(fromY), _mm_mul_ps(_mm_set1_ps(dy), t));
+		const __m128 z = _mm_add_ps(_mm_set1_ps(from.z), _mm_mul_ps(_mm_set1_ps(dz), t));
+
+		const __m128 fx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(x, minX), invCell), zero), maxFx);
+		const __m128 fz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, minZ), invCell), zero), maxFz);
+
+		// No SSE2 min_epi32, but ix > maxIx exactly when fx is on the last sample
+		__m128i ix = _mm_cvttps_epi32(fx);
+		__m128i iz = _mm_cvttps_epi32(fz);
+		const __m128i overX = _mm_cmpgt_epi32(ix, maxIx);
+		const __m128i overZ = _mm_cmpgt_epi32(iz, maxIz);
+		ix = _mm_or_si128(_mm_andnot_si128(overX, ix), _mm_and_si128(overX, maxIx));
+		iz = _mm_or_si128(_mm_andnot_si128(overZ, iz), _mm_and_si128(overZ, maxIz));
+		const __m128 tx = _mm_sub_ps(fx, _mm_cvtepi32_ps(ix));
+		const __m128 tz = _mm_sub_ps(fz, _mm_cvtepi32_ps(iz));
+
+		// SSE2 has no gather, the corner loads are scalar
+		alignas(16) int32_t ixs[4];
+		alignas(16) int32_t izs[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(ixs), ix);
+		_mm_store_si128(reinterpret_cast<__m128i*>(izs), iz);
+		alignas(16) float h00[4], h10[4], h01[4], h11[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			const float* row = heights + static_cast<size_t>(izs[k]) * samplesX + ixs[k];
+			h00[k] = row[0];
+			h10[k] = row[1];
+			h01[k] = row[samplesX];
+			h11[k] = row[samplesX + 1];
+		}
+
+		const __m128 a = _mm_load_ps(h00);
+		const __m128 b = _mm_load_ps(h01);
+		const __m128 h0 = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h10), a), tx));
+		const __m128 h1 = _mm_add_ps(b, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h11), b), tx));
+		const __m128 height = _mm_add_ps(h0, _mm_mul_ps(_mm_sub_ps(h1, h0), tz));
+
+		if (_mm_movemask_ps(_mm_cmpgt_ps(height, y)) != 0)
+			return false;
+	}
+#endif
+
+	for (; i < steps; ++i)
+	{
+		const float t = static_cast<float>(i) * invSteps;
+		if (m_Terrain.GetHeight(from.x + dx * t, from.z + dz * t) > fromY + dy * t)
+			return false;
+	}
+	return true;
+}
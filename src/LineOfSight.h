@@ -0,0 +1,93 @@
+#ifndef _LineOfSight_
+#define _LineOfSight_
+
+#include <ScriptUtils.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class TerrainCache;
+
+struct LosQuery
+{
+	Vector from;
+	Vector to;
+};
+
+// Terrain line of sight, which the game doesn't expose. Rays are marched
+// over the TerrainCache heightfield (four samples at a time with SSE2,
+// stopping at the first one under the terrain), and the turn comes from
+// Update, so a check never calls into the game. Objects don't block sight,
+// only terrain does.
+//
+// Results are cached by the pair of cache cells the two ends fall in and
+// reused for a few turns, so turrets polling the same targets every tick
+// mostly hit the cache. Within a cell the answer is shared, keep the cell
+// size well under the distances being checked.
+class LineOfSight
+{
+public:
+	explicit LineOfSight(const TerrainCache& terrain);
+
+	// Sets the turn results are cached against. Call once per Update with
+	// GetLockstepTurn(). Nothing is cached until the first call.
+	void Update(long turn) { m_Turn = turn; }
+
+	// Added to from.y and to.y, since object positions sit on the ground.
+	// Clears the cache.
+	void SetHeights(float eyeHeight, float targetHeight);
+
+	// How many turns a result is reused for, 0 turns the cache off.
+	void SetCacheTurns(int turns) { m_CacheTurns = turns; }
+
+	// Clears the cache.
+	void SetCacheCellSize(float meters);
+
+	// True if nothing on the terrain is in the way. Always true until the
+	// TerrainCache is loaded.
+	bool CanSee(const Vector& from, const Vector& to);
+
+	// visible[i] = CanSee(queries[i].from, queries[i].to). visible must be at
+	// least as long as queries.
+	void CanSee(std::span<const LosQuery> queries, std::span<uint8_t> visible);
+
+	// Forgets every cached result. Call from PostLoad.
+	void Clear();
+
+	struct Stats
+	{
+		uint64_t queries;
+		uint64_t cacheHits;
+		// Terrain samples taken by rays that weren't cached
+		uint64_t samples;
+	};
+
+	const Stats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = {}; }
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		int32_t turn;
+		uint8_t visible;
+	};
+
+	bool Lookup(const Vector& from, const Vector& to);
+	bool Trace(const Vector& from, const Vector& to);
+
+	const TerrainCache& m_Terrain;
+
+	float m_EyeHeight = 2.0f;
+	float m_TargetHeight = 1.0f;
+	int m_CacheTurns = 10;
+	long m_Turn = -1;
+	float m_InvCacheCellSize = 1.0f / 16.0f;
+
+	// Direct mapped, a collision just replaces the older entry
+	std::vector<Entry> m_Cache;
+	Stats m_Stats{};
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _MappedFile_
+#define _MappedFile_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read-only memory map of a whole file. Pages are loaded by the OS as
+// they're touched, so opening a big file costs next to nothing until it's
+// read. Unmapped by Close or on destruction.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { Close(); }
+
+	// False if the file is missing, empty or can't be mapped.
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	const uint8_t* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+};
+
+#endif
@@ -1,5 +1,29 @@
 #include <ScriptUtils.h>
 
+#include <cstdio>
+#include <vector>
+
+#include "EntityTable.h"
+#include "EventBus.h"
+#include "ExportBuffer.h"
+#include "FrameArena.h"
+#include "InfluenceMap.h"
+#include "LineOfSight.h"
+#include "OdfCache.h"
+#include "OrderBuffer.h"
+#include "PathCache.h"
+#include "Pathfinder.h"
+#include "Profiler.h"
+#include "RandomStream.h"
+#include "SaveBuffer.h"
+#include "ScriptScheduler.h"
+#include "SpatialGrid.h"
+#include "SquadManager.h"
+#include "TargetAssigner.h"
+#include "TerrainCache.h"
+#include "TimerWheel.h"
+#include "WorkerPool.h"
+
 // Import table from the game, defined here, declared in ScriptUtils.h, note that the time field will always be 0
 // for some reason, if you want the true time value use misnExport.misnImport->time
 MisnImport misnImport{};
@@ -8,44 +32,179 @@ MisnImport misnImport{};
 // to stay in scope for the duration of the game.
 MisnExport misnExport{};
 
+// Scratch memory for the current Update, reset at the top of it. Declared first since other globals take buffers from it.
+FrameArena frameArena{};
+
+// Per-frame snapshot of every object the game has told us about, refreshed at the top of Update.
+EntityTable entityTable{};
+
+// XZ bucket grid over the entity snapshot for proximity queries, rebuilt right after the snapshot.
+SpatialGrid spatialGrid{};
+
+// ODF values read through the cache only hit the game once. ODFs never change mid-mission, so it's never cleared.
+OdfCache odfCache{};
+
+// Turn-based timers for deferred mission events. Register event callbacks in InitialSetup so Load can find them.
+TimerWheel timerWheel{};
+
+// Runs coroutine mission sequences (ScriptTask). Coroutines aren't saved, restart them from PostLoad.
+ScriptScheduler scriptScheduler{};
+
+// Multi-subscriber fan out for the MisnExport2 callbacks (PreSnipe, PreOrdnanceHit, etc).
+MissionEventBus eventBus{};
+
+// Unit orders issued during Update, sent at the end of it minus the ones that wouldn't change anything.
+OrderBuffer orderBuffer{};
+
+// Script-side unit squads with bulk orders, which go out through orderBuffer.
+SquadManager squadManager{ orderBuffer, &frameArena };
+
+// Every AI path's points, for distance/progress/inside queries. Change paths through it, not the exports.
+PathCache pathCache{};
+
+// Grid A* over the terrain for scripted routes. Samples the terrain on first use.
+Pathfinder pathfinder{ &frameArena };
+
+// Terrain heights on a grid, saved per map under the output path so later runs just map the file.
+TerrainCache terrainCache{};
+
+// Terrain line of sight over terrainCache, with results reused for a few turns.
+LineOfSight lineOfSight{ terrainCache };
+
+// Per-team influence for threat, frontline and spawn choices. Updated incrementally from entityTable.
+InfluenceMap influenceMap{ &frameArena };
+
+// Spreads groups of attackers over nearby enemies, ordering through orderBuffer.
+TargetAssigner targetAssigner{ orderBuffer };
+
+// Lockstep-safe random numbers, one stream per subsystem. Seeded each frame from SetRandomSeed.
+RandomStreams randomStreams{};
+
+// GetAllGameObjectHandles lands here. Kept between loads so it's usually one call.
+ExportBuffer<Handle> objectHandles{};
+
+// Threads for work that doesn't fit in a tick, merged at a fixed turn, and for ParallelFor over the table. Shut down in PostRun.
+WorkerPool workerPool{ &frameArena };
+
+// Holds the loaded save between Load and PostLoad, when the handles read out of it get remapped.
+SaveReader saveReader{};
+
 void DLLAPI InitialSetup()
 {
     PrintConsoleMessage("Hello DLL Mission!");
+
+	// Declare ODF values used on hot paths with odfCache.Declare() above this, then fill them all in one pass
+	odfCache.Prefetch();
+
+	pathCache.Load();
+	terrainCache.Load();
+
+	// Samples the whole map, which doesn't fit in a tick
+	pathfinder.Build();
+
+	workerPool.Start();
 }
 
 bool DLLAPI Save(bool missionSave)
 {
-	return true;
+	// Mission saves (from the editor) don't carry DLL state
+	if (missionSave)
+		return true;
+
+	// Everything goes into one buffer and out in a single Write
+	SaveWriter writer{};
+	timerWheel.Save(writer);
+	squadManager.Save(writer);
+	randomStreams.Save(writer);
+	return writer.Flush();
 }
 
 bool DLLAPI Load(bool missionSave)
 {
-	return true;
+	if (missionSave)
+		return true;
+
+	if (!saveReader.Load())
+		return false;
+
+	return timerWheel.Load(saveReader) && squadManager.Load(saveReader) && randomStreams.Load(saveReader);
 }
 
 bool DLLAPI PostLoad(bool missionSave)
 {
+	// Remap every handle read during Load in one ConvertHandles call
+	if (!missionSave)
+	{
+		saveReader.ConvertHandles();
+		squadManager.PostLoad();
+		saveReader.Clear();
+	}
+
+	// Handles aren't stable across a load, so rebuild the table from what the game has now
+	entityTable.Clear();
+	orderBuffer.Clear();
+	pathCache.Invalidate();
+	lineOfSight.Clear();
+	influenceMap.Clear();
+	targetAssigner.Clear();
+	workerPool.Cancel();
+
+	for (Handle h : QueryAllGameObjectHandles(objectHandles))
+		entityTable.Add(h);
+
 	return true;
 }
 
 void DLLAPI AddObject(Handle h)
 {
-
+	entityTable.Add(h);
 }
 
 void DLLAPI DeleteObject(Handle h)
 {
-
+	entityTable.Remove(h);
+	orderBuffer.Remove(h);
+	squadManager.Remove(h);
+	targetAssigner.Remove(h);
+	scriptScheduler.NotifyDestroyed(h);
 }
 
 void DLLAPI Update()
 {
+	// Nothing from the last frame's scratch is still in use
+	frameArena.Reset();
+
+	// Read once, everything below works on this turn
+	const long turn = GetLockstepTurn();
+
+	// Before anything can schedule or start a wait, so both count from this turn
+	timerWheel.BeginTurn(turn);
+	scriptScheduler.BeginTurn(turn);
+
+	entityTable.Refresh(turn);
+	spatialGrid.Build(entityTable);
+	squadManager.Refresh(entityTable);
+	influenceMap.Update(entityTable);
+	lineOfSight.Update(turn);
 
+	// Background results land here, before anything this turn acts on them
+	workerPool.Join(turn);
+
+	timerWheel.Advance(turn);
+	scriptScheduler.Update(turn);
+
+	// Keep this last so it sees every order from this tick
+	orderBuffer.Flush(turn);
+
+	// Callbacks until the next Update may be on the next turn
+	timerWheel.EndTurn();
+	scriptScheduler.EndTurn();
 }
 
 void DLLAPI PostRun()
 {
-
+	// Last call before the DLL goes away, and the only safe place to join
+	workerPool.Shutdown();
 }
 
 bool DLLAPI AddPlayer(DPID id, int Team, bool ShouldCreateThem)
@@ -65,6 +224,8 @@ EjectKillRetCodes DLLAPI PlayerEjected(Handle DeadObjectHandle)
 
 EjectKillRetCodes DLLAPI ObjectKilled(Handle DeadObjectHandle, Handle KillersHandle)
 {
+	squadManager.Remove(DeadObjectHandle);
+	scriptScheduler.NotifyDestroyed(DeadObjectHandle);
 	return DoEjectPilot;
 }
 
@@ -85,12 +246,45 @@ void DLLAPI SetWorld(int nextWorld)
 
 void DLLAPI ProcessCommand(unsigned long crc)
 {
+#ifdef MISSION_PROFILING
+	if (Profiler::ProcessCommand(crc))
+		return;
+#endif
 
+	if (crc == CalcCRC("dll.orders"))
+	{
+		const OrderBuffer::Stats& stats = orderBuffer.GetStats();
+		char msg[128];
+		snprintf(msg, sizeof(msg), "orders: %llu issued, %llu coalesced, %llu suppressed, %llu sent, %llu rechecked",
+			static_cast<unsigned long long>(stats.issued), static_cast<unsigned long long>(stats.coalesced),
+			static_cast<unsigned long long>(stats.suppressed), static_cast<unsigned long long>(stats.flushed),
+			static_cast<unsigned long long>(stats.rechecked));
+		PrintConsoleMessage(msg);
+	}
+	else if (crc == CalcCRC("dll.arena"))
+	{
+		const FrameArena::Stats& stats = frameArena.GetStats();
+		char msg[128];
+		snprintf(msg, sizeof(msg), "arena: %zu KB block, %zu KB peak, %llu heap blocks over %llu frames",
+			frameArena.GetCapacity() / 1024, stats.peak / 1024,
+			static_cast<unsigned long long>(stats.heapBlocks), static_cast<unsigned long long>(stats.frames));
+		PrintConsoleMessage(msg);
+	}
+	else if (crc == CalcCRC("dll.workers"))
+	{
+		const WorkerPool::Stats& stats = workerPool.GetStats();
+		char msg[192];
+		snprintf(msg, sizeof(msg), "workers: %d threads, %llu jobs, %llu ran on main, %llu waited, %zu pending, %llu parallel runs, %llu steals",
+			workerPool.GetThreadCount(), static_cast<unsigned long long>(stats.submitted), static_cast<unsigned long long>(stats.ranOnMain),
+			static_cast<unsigned long long>(stats.waited), workerPool.GetPendingCount(),
+			static_cast<unsigned long long>(stats.parallelRuns), static_cast<unsigned long long>(stats.steals));
+		PrintConsoleMessage(msg);
+	}
 }
 
 void DLLAPI SetRandomSeed(unsigned long seed)
 {
-
+	randomStreams.SetSeed(seed);
 }
 
 /*
@@ -104,23 +298,24 @@ MisnExport* DLLAPI GetMisnAPI(MisnImport* import)
 	misnExport.misnImport = import;
 	misnExport.version = LATEST_DLL_VERSION;
 	misnExport.VersionModifier = LATEST_DLL_VERSION_MODIFIER;
-	misnExport.InitialSetup = InitialSetup;
-	misnExport.Save = Save;
-	misnExport.Load = Load;
-	misnExport.PostLoad = PostLoad;
-	misnExport.AddObject = AddObject;
-	misnExport.DeleteObject = DeleteObject;
-	misnExport.Update = Update;
-	misnExport.PostRun = PostRun;
-	misnExport.AddPlayer = AddPlayer;
-	misnExport.DeletePlayer = DeletePlayer;
-	misnExport.PlayerEjected = PlayerEjected;
-	misnExport.ObjectKilled = ObjectKilled;
-	misnExport.ObjectSniped = ObjectSniped;
-	misnExport.GetNextRandomVehicleODF = GetNextRandomVehicleODF;
-	misnExport.SetWorld = SetWorld;
-	misnExport.ProcessCommand = ProcessCommand;
-	misnExport.SetRandomSeed = SetRandomSeed;
+	// PROFILED_EXPORT is just the function itself unless MISSION_PROFILING is on
+	misnExport.InitialSetup = PROFILED_EXPORT(PROFILE_INITIAL_SETUP, InitialSetup);
+	misnExport.Save = PROFILED_EXPORT(PROFILE_SAVE, Save);
+	misnExport.Load = PROFILED_EXPORT(PROFILE_LOAD, Load);
+	misnExport.PostLoad = PROFILED_EXPORT(PROFILE_POST_LOAD, PostLoad);
+	misnExport.AddObject = PROFILED_EXPORT(PROFILE_ADD_OBJECT, AddObject);
+	misnExport.DeleteObject = PROFILED_EXPORT(PROFILE_DELETE_OBJECT, DeleteObject);
+	misnExport.Update = PROFILED_EXPORT(PROFILE_UPDATE, Update);
+	misnExport.PostRun = PROFILED_EXPORT(PROFILE_POST_RUN, PostRun);
+	misnExport.AddPlayer = PROFILED_EXPORT(PROFILE_ADD_PLAYER, AddPlayer);
+	misnExport.DeletePlayer = PROFILED_EXPORT(PROFILE_DELETE_PLAYER, DeletePlayer);
+	misnExport.PlayerEjected = PROFILED_EXPORT(PROFILE_PLAYER_EJECTED, PlayerEjected);
+	misnExport.ObjectKilled = PROFILED_EXPORT(PROFILE_OBJECT_KILLED, ObjectKilled);
+	misnExport.ObjectSniped = PROFILED_EXPORT(PROFILE_OBJECT_SNIPED, ObjectSniped);
+	misnExport.GetNextRandomVehicleODF = PROFILED_EXPORT(PROFILE_GET_NEXT_RANDOM_VEHICLE_ODF, GetNextRandomVehicleODF);
+	misnExport.SetWorld = PROFILED_EXPORT(PROFILE_SET_WORLD, SetWorld);
+	misnExport.ProcessCommand = PROFILED_EXPORT(PROFILE_PROCESS_COMMAND, ProcessCommand);
+	misnExport.SetRandomSeed = PROFILED_EXPORT(PROFILE_SET_RANDOM_SEED, SetRandomSeed);
 
 	return &misnExport;
 }
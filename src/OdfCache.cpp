@@ -0,0 +1,229 @@
+#include "OdfCache.h"
+
+#include <algorithm>
+
+OdfCache::~OdfCache()
+{
+	Clear();
+}
+
+uint32_t OdfCache::InternString(const char* str)
+{
+	auto it = m_StringIds.find(str);
+	if (it != m_StringIds.end())
+		return it->second;
+
+	const uint32_t id = static_cast<uint32_t>(m_Strings.size());
+	m_Strings.emplace_back(str);
+	m_StringIds.emplace(m_Strings.back(), id);
+	return id;
+}
+
+OdfKey OdfCache::Intern(const char* file, const char* block, const char* name)
+{
+	constexpr uint32_t STRING_ID_MASK = (1u << 21) - 1;
+
+	const uint32_t fileId = InternString(file ? file : "");
+	const uint32_t blockId = InternString(block ? block : "");
+	const uint32_t nameId = InternString(name ? name : "");
+	if (fileId > STRING_ID_MASK || blockId > STRING_ID_MASK || nameId > STRING_ID_MASK)
+		return INVALID_ODF_KEY;
+
+	const uint64_t packed = (static_cast<uint64_t>(fileId) << 42) | (static_cast<uint64_t>(blockId) << 21) | nameId;
+	auto it = m_Keys.find(packed);
+	if (it != m_Keys.end())
+		return it->second;
+
+	const OdfKey key = m_EntryCount.load(std::memory_order_relaxed);
+	const uint32_t chunkIndex = key >> CHUNK_BITS;
+	if (chunkIndex >= MAX_CHUNKS)
+		return INVALID_ODF_KEY;
+
+	Entry* chunk = m_Chunks[chunkIndex].load(std::memory_order_relaxed);
+	if (!chunk)
+	{
+		chunk = new Entry[CHUNK_SIZE];
+		m_Chunks[chunkIndex].store(chunk, std::memory_order_release);
+	}
+
+	Entry& e = chunk[key & (CHUNK_SIZE - 1)];
+	e.file = fileId;
+	e.block = blockId;
+	e.name = nameId;
+
+	m_Keys.emplace(packed, key);
+	m_EntryCount.store(key + 1, std::memory_order_release);
+	return key;
+}
+
+OdfKey OdfCache::Declare(const char* file, const char* block, const char* name, OdfValueType type)
+{
+	const OdfKey key = Intern(file, block, name);
+	if (key != INVALID_ODF_KEY)
+		m_Declared.push_back({ key, type });
+	return key;
+}
+
+void OdfCache::Prefetch()
+{
+	// Group by file so each ODF only gets opened once
+	std::stable_sort(m_Declared.begin(), m_Declared.end(), [this](const Declared& a, const Declared& b)
+	{
+		return GetEntry(a.key)->file < GetEntry(b.key)->file;
+	});
+
+	for (size_t i = 0; i < m_Declared.size(); )
+	{
+		const uint32_t fileId = GetEntry(m_Declared[i].key)->file;
+		const char* file = m_Strings[fileId].c_str();
+
+		bool opened = false;
+		for (; i < m_Declared.size() && GetEntry(m_Declared[i].key)->file == fileId; ++i)
+		{
+			Entry& e = *GetEntry(m_Declared[i].key);
+			bool found;
+			if (IsFilled(e, m_Declared[i].type, found))
+				continue;
+
+			if (!opened)
+			{
+				OpenODF(file);
+				opened = true;
+			}
+			Fill(e, m_Declared[i].type);
+		}
+
+		if (opened)
+			CloseODF(file);
+	}
+
+	m_Declared.clear();
+}
+
+void OdfCache::Fill(Entry& e, OdfValueType type)
+{
+	const char* file = m_Strings[e.file].c_str();
+	const char* block = m_Strings[e.block].c_str();
+	const char* name = m_Strings[e.name].c_str();
+
+	bool found = false;
+	switch (type)
+	{
+	case ODF_VALUE_INT:
+		found = GetODFInt(file, block, name, &e.intValue) != 0;
+		break;
+	case ODF_VALUE_FLOAT:
+		found = GetODFFloat(file, block, name, &e.floatValue) != 0;
+		break;
+	case ODF_VALUE_BOOL:
+		found = GetODFBool(file, block, name, &e.boolValue) != 0;
+		break;
+	case ODF_VALUE_STRING:
+	{
+		char buffer[256] = {};
+		found = GetODFString(file, block, name, sizeof(buffer), buffer) != 0;
+		e.stringValue = buffer;
+		break;
+	}
+	default:
+		return;
+	}
+
+	const uint32_t bit = 1u << type;
+	if (found)
+		e.found.fetch_or(bit, std::memory_order_relaxed);
+	e.filled.fetch_or(bit, std::memory_order_release);
+}
+
+OdfCache::Entry* OdfCache::FillOne(OdfKey key, OdfValueType type)
+{
+	Entry* e = GetEntry(key);
+	if (!e)
+		return nullptr;
+
+	bool found;
+	if (!IsFilled(*e, type, found))
+	{
+		const char* file = m_Strings[e->file].c_str();
+		OpenODF(file);
+		Fill(*e, type);
+		CloseODF(file);
+	}
+	return e;
+}
+
+int OdfCache::GetInt(OdfKey key, int defval)
+{
+	const Entry* e = FillOne(key, ODF_VALUE_INT);
+	return e && (e->found.load(std::memory_order_relaxed) & (1u << ODF_VALUE_INT)) ? e->intValue : defval;
+}
+
+float OdfCache::GetFloat(OdfKey key, float defval)
+{
+	const Entry* e = FillOne(key, ODF_VALUE_FLOAT);
+	return e && (e->found.load(std::memory_order_relaxed) & (1u << ODF_VALUE_FLOAT)) ? e->floatValue : defval;
+}
+
+bool OdfCache::GetBool(OdfKey key, bool defval)
+{
+	const Entry* e = FillOne(key, ODF_VALUE_BOOL);
+	return e && (e->found.load(std::memory_order_relaxed) & (1u << ODF_VALUE_BOOL)) ? e->boolValue : defval;
+}
+
+const char* OdfCache::GetString(OdfKey key, const char* defval)
+{
+	const Entry* e = FillOne(key, ODF_VALUE_STRING);
+	return e && (e->found.load(std::memory_order_relaxed) & (1u << ODF_VALUE_STRING)) ? e->stringValue.c_str() : defval;
+}
+
+bool OdfCache::TryGetInt(OdfKey key, int& value) const
+{
+	const Entry* e = GetEntry(key);
+	bool found = false;
+	if (!e || !IsFilled(*e, ODF_VALUE_INT, found) || !found)
+		return false;
+	value = e->intValue;
+	return true;
+}
+
+bool OdfCache::TryGetFloat(OdfKey key, float& value) const
+{
+	const Entry* e = GetEntry(key);
+	bool found = false;
+	if (!e || !IsFilled(*e, ODF_VALUE_FLOAT, found) || !found)
+		return false;
+	value = e->floatValue;
+	return true;
+}
+
+bool OdfCache::TryGetBool(OdfKey key, bool& value) const
+{
+	const Entry* e = GetEntry(key);
+	bool found = false;
+	if (!e || !IsFilled(*e, ODF_VALUE_BOOL, found) || !found)
+		return false;
+	value = e->boolValue;
+	return true;
+}
+
+bool OdfCache::TryGetString(OdfKey key, const char*& value) const
+{
+	const Entry* e = GetEntry(key);
+	bool found = false;
+	if (!e || !IsFilled(*e, ODF_VALUE_STRING, found) || !found)
+		return false;
+	value = e->stringValue.c_str();
+	return true;
+}
+
+void OdfCache::Clear()
+{
+	for (auto& chunk : m_Chunks)
+		delete[] chunk.exchange(nullptr, std::memory_order_relaxed);
+
+	m_EntryCount.store(0, std::memory_order_relaxed);
+	m_Strings.clear();
+	m_StringIds.clear();
+	m_Keys.clear();
+	m_Declared.clear();
+}
@@ -0,0 +1,148 @@
+#ifndef _OdfCache_
+#define _OdfCache_
+
+#include <ScriptUtils.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Types the cache can hold for a key. A key can be read as more than one
+// type, each one is looked up and cached separately.
+enum OdfValueType
+{
+	ODF_VALUE_INT,
+	ODF_VALUE_FLOAT,
+	ODF_VALUE_BOOL,
+	ODF_VALUE_STRING,
+	ODF_VALUE_TYPE_COUNT
+};
+
+// Interned (file, block, name) triple. Get one from OdfCache::Intern or
+// OdfCache::Declare once, then keep it around instead of the strings.
+typedef uint32_t OdfKey;
+const OdfKey INVALID_ODF_KEY = 0xFFFFFFFF;
+
+// Cache over the GetODFInt/GetODFFloat/GetODFBool/GetODFString exports.
+// Values are looked up on first access (with OpenODF/CloseODF around the
+// read) and served from memory after that. Whether the game found the
+// value is cached too, so a missing key returns the caller's defval
+// without asking the game again.
+//
+// Keys that are known up front can be declared at InitialSetup and filled
+// together with Prefetch(), which opens each ODF file only once.
+//
+// Interning and the Get* calls must happen on the main thread since they
+// may call into the game. The TryGet* calls never do, and are safe to
+// call from any thread while the main thread keeps filling the cache.
+class OdfCache
+{
+public:
+	OdfCache() = default;
+	OdfCache(const OdfCache&) = delete;
+	OdfCache& operator=(const OdfCache&) = delete;
+	~OdfCache();
+
+	// Returns the key for (file, block, name), creating it if needed.
+	// file is the full ODF name including extension, e.g. "ivtank.odf".
+	OdfKey Intern(const char* file, const char* block, const char* name);
+
+	// Interns the key and queues it to be filled as type by Prefetch().
+	OdfKey Declare(const char* file, const char* block, const char* name, OdfValueType type);
+
+	// Fills every declared key that isn't cached yet, one OpenODF/CloseODF
+	// per file.
+	void Prefetch();
+
+	int GetInt(OdfKey key, int defval = 0);
+	float GetFloat(OdfKey key, float defval = 0.0f);
+	bool GetBool(OdfKey key, bool defval = false);
+	// The returned string lives as long as the cache.
+	const char* GetString(OdfKey key, const char* defval = "");
+
+	int GetInt(const char* file, const char* block, const char* name, int defval = 0) { return GetInt(Intern(file, block, name), defval); }
+	float GetFloat(const char* file, const char* block, const char* name, float defval = 0.0f) { return GetFloat(Intern(file, block, name), defval); }
+	bool GetBool(const char* file, const char* block, const char* name, bool defval = false) { return GetBool(Intern(file, block, name), defval); }
+	const char* GetString(const char* file, const char* block, const char* name, const char* defval = "") { return GetString(Intern(file, block, name), defval); }
+
+	// Lock-free reads. Return false if the value isn't cached yet or the
+	// game didn't have it, leaving value untouched.
+	bool TryGetInt(OdfKey key, int& value) const;
+	bool TryGetFloat(OdfKey key, float& value) const;
+	bool TryGetBool(OdfKey key, bool& value) const;
+	bool TryGetString(OdfKey key, const char*& value) const;
+
+	// Drops all keys and values. Not safe while other threads are reading.
+	void Clear();
+
+	size_t Size() const { return m_EntryCount; }
+
+private:
+	static constexpr uint32_t CHUNK_BITS = 8;
+	static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+	static constexpr uint32_t MAX_CHUNKS = 256;
+
+	struct Entry
+	{
+		uint32_t file = 0;
+		uint32_t block = 0;
+		uint32_t name = 0;
+
+		// Bit per OdfValueType. found (and the value) is written before the
+		// matching filled bit is published, and neither changes after that.
+		std::atomic<uint32_t> filled{0};
+		std::atomic<uint32_t> found{0};
+
+		int intValue = 0;
+		float floatValue = 0.0f;
+		bool boolValue = false;
+		std::string stringValue;
+	};
+
+	uint32_t InternString(const char* str);
+
+	Entry* GetEntry(OdfKey key) const
+	{
+		if (key >= m_EntryCount)
+			return nullptr;
+		Entry* chunk = m_Chunks[key >> CHUNK_BITS].load(std::memory_order_acquire);
+		return chunk ? &chunk[key & (CHUNK_SIZE - 1)] : nullptr;
+	}
+
+	// Reads one value from the game into e. The ODF must be open.
+	void Fill(Entry& e, OdfValueType type);
+	// Same as Fill, but opens and closes the ODF around the read.
+	Entry* FillOne(OdfKey key, OdfValueType type);
+
+	static bool IsFilled(const Entry& e, OdfValueType type, bool& found)
+	{
+		const uint32_t bit = 1u << type;
+		if (!(e.filled.load(std::memory_order_acquire) & bit))
+			return false;
+		found = (e.found.load(std::memory_order_relaxed) & bit) != 0;
+		return true;
+	}
+
+	std::array<std::atomic<Entry*>, MAX_CHUNKS> m_Chunks{};
+	std::atomic<uint32_t> m_EntryCount{0};
+
+	// Interned strings. A deque so the c_str() pointers stay put.
+	std::deque<std::string> m_Strings;
+	std::unordered_map<std::string, uint32_t> m_StringIds;
+
+	// (file, block, name) string ids packed 21 bits each -> key
+	std::unordered_map<uint64_t, OdfKey> m_Keys;
+
+	struct Declared
+	{
+		OdfKey key;
+		OdfValueType type;
+	};
+	std::vector<Declared> m_Declared;
+};
+
+#endif
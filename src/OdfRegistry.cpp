@@ -0,0 +1,51 @@
+#include "OdfRegistry.h"
+
+#include <cctype>
+
+std::string OdfRegistry::Normalize(std::string_view cfg)
+{
+	std::string name(cfg);
+	for (char& c : name)
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+	// Get_CFG doesn't include the extension, but be forgiving about it
+	if (name.size() > 4 && name.ends_with(".odf"))
+		name.resize(name.size() - 4);
+	return name;
+}
+
+OdfId OdfRegistry::Intern(const char* cfg)
+{
+	if (!cfg || !*cfg)
+		return INVALID_ODF_ID;
+
+	std::string name = Normalize(cfg);
+	auto it = m_Ids.find(name);
+	if (it != m_Ids.end())
+		return it->second;
+
+	if (m_Names.size() >= INVALID_ODF_ID)
+		return INVALID_ODF_ID;
+
+	const OdfId id = static_cast<OdfId>(m_Names.size());
+	m_Names.push_back(name);
+	m_Ids.emplace(std::move(name), id);
+	return id;
+}
+
+OdfId OdfRegistry::Find(const char* cfg) const
+{
+	if (!cfg || !*cfg)
+		return INVALID_ODF_ID;
+
+	auto it = m_Ids.find(Normalize(cfg));
+	return it != m_Ids.end() ? it->second : INVALID_ODF_ID;
+}
+
+OdfSet OdfRegistry::MakeSet(std::initializer_list<const char*> cfgs)
+{
+	OdfSet set;
+	for (const char* cfg : cfgs)
+		set.Add(Intern(cfg));
+	return set;
+}
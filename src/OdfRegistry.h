@@ -0,0 +1,79 @@
+#ifndef _OdfRegistry_
+#define _OdfRegistry_
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dense id for a config name (the Get_CFG string, e.g. "ivtank"). Ids are
+// handed out in the order names are first seen and never reused, so they
+// stay valid for the life of the DLL.
+typedef uint16_t OdfId;
+const OdfId INVALID_ODF_ID = 0xFFFF;
+
+// Bitset over OdfIds, for "is this one of these unit types" tests in a
+// single bit lookup. Build one with OdfRegistry::MakeSet.
+class OdfSet
+{
+public:
+	void Add(OdfId id)
+	{
+		if (id == INVALID_ODF_ID)
+			return;
+		if (id / 64 >= m_Bits.size())
+			m_Bits.resize(id / 64 + 1, 0);
+		m_Bits[id / 64] |= uint64_t(1) << (id % 64);
+	}
+
+	void Remove(OdfId id)
+	{
+		if (id / 64 < m_Bits.size())
+			m_Bits[id / 64] &= ~(uint64_t(1) << (id % 64));
+	}
+
+	bool Contains(OdfId id) const
+	{
+		return id / 64 < m_Bits.size() && (m_Bits[id / 64] >> (id % 64)) & 1;
+	}
+
+	void Clear() { m_Bits.clear(); }
+
+private:
+	std::vector<uint64_t> m_Bits;
+};
+
+// Interns config names into OdfIds. Names are compared case-insensitively,
+// same as the game does for ODF names.
+class OdfRegistry
+{
+public:
+	// Returns the id for cfg, assigning the next free one if it hasn't been
+	// seen yet. Returns INVALID_ODF_ID if cfg is empty or the ids ran out.
+	OdfId Intern(const char* cfg);
+
+	// Returns the id for cfg, or INVALID_ODF_ID if it was never interned.
+	OdfId Find(const char* cfg) const;
+
+	// Returns the (lowercased) name for an id, or "" if it's invalid.
+	const char* GetName(OdfId id) const
+	{
+		return id < m_Names.size() ? m_Names[id].c_str() : "";
+	}
+
+	// Interns every name and returns a set holding all of them. Names don't
+	// need to have been seen yet, e.g. MakeSet({ "ivtank", "ivscout" }).
+	OdfSet MakeSet(std::initializer_list<const char*> cfgs);
+
+	size_t Size() const { return m_Names.size(); }
+
+private:
+	static std::string Normalize(std::string_view cfg);
+
+	std::vector<std::string> m_Names;
+	std::unordered_map<std::string, OdfId> m_Ids;
+};
+
+#endif
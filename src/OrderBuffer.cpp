@@ -0,0 +1,269 @@
+#include "OrderBuffer.h"
+
+#include <algorithm>
+
+void OrderBuffer::Goto(Handle me, const Vector& pos, int priority)
+{
+	Push({ me, ORDER_GOTO_POSITION, CMD_GO, priority, 0, 0, pos, NO_PATH });
+}
+
+void OrderBuffer::Goto(Handle me, Handle him, int priority)
+{
+	Push({ me, ORDER_GOTO_HANDLE, CMD_GO, priority, 0, him, Vector(0.0f, 0.0f, 0.0f), NO_PATH });
+}
+
+void OrderBuffer::Goto(Handle me, ConstName path, int priority)
+{
+	Push({ me, ORDER_GOTO_PATH, CMD_GO, priority, 0, 0, Vector(0.0f, 0.0f, 0.0f), InternPath(path) });
+}
+
+void OrderBuffer::Attack(Handle me, Handle him, int priority)
+{
+	Push({ me, ORDER_ATTACK, CMD_ATTACK, priority, 0, him, Vector(0.0f, 0.0f, 0.0f), NO_PATH });
+}
+
+void OrderBuffer::Follow(Handle me, Handle him, int priority)
+{
+	Push({ me, ORDER_FOLLOW, CMD_FOLLOW, priority, 0, him, Vector(0.0f, 0.0f, 0.0f), NO_PATH });
+}
+
+void OrderBuffer::Defend(Handle me, int priority)
+{
+	Push({ me, ORDER_DEFEND, CMD_DEFEND, priority, 0, 0, Vector(0.0f, 0.0f, 0.0f), NO_PATH });
+}
+
+void OrderBuffer::Patrol(Handle me, ConstName path, int priority)
+{
+	Push({ me, ORDER_PATROL, CMD_PATROL, priority, 0, 0, Vector(0.0f, 0.0f, 0.0f), InternPath(path) });
+}
+
+void OrderBuffer::SetCommand(Handle me, int cmd, int priority, Handle who, const Vector& where, int param)
+{
+	Push({ me, ORDER_COMMAND_WHERE, cmd, priority, param, who, where, NO_PATH });
+}
+
+void OrderBuffer::SetCommand(Handle me, int cmd, int priority, Handle who, ConstName path, int param)
+{
+	Push({ me, ORDER_COMMAND_PATH, cmd, priority, param, who, Vector(0.0f, 0.0f, 0.0f), InternPath(path) });
+}
+
+void OrderBuffer::Flush(long turn)
+{
+	// Units ordered for the first time go on the end and get sorted in after
+	const size_t sorted = m_Sent.size();
+
+	// Pending is in first-issued order, so orders go out in a stable order every tick
+	for (const Order& order : m_Pending)
+	{
+		// Removed mid-tick
+		if (order.me == 0)
+		{
+			++m_Stats.suppressed;
+			continue;
+		}
+
+		SentOrder* sent = FindSent(order.me, sorted);
+		if (sent && IsRedundant(order, *sent, turn))
+		{
+			++m_Stats.suppressed;
+			continue;
+		}
+
+		Send(order);
+		const SentOrder next{ order, turn + m_RecheckTurns };
+		if (sent)
+			*sent = next;
+		else
+			m_Sent.push_back(next);
+		++m_Stats.flushed;
+	}
+
+	if (m_Sent.size() != sorted)
+	{
+		std::sort(m_Sent.begin(), m_Sent.end(), [](const SentOrder& a, const SentOrder& b)
+		{
+			return a.order.me < b.order.me;
+		});
+	}
+
+	ClearPending();
+}
+
+void OrderBuffer::Remove(Handle h)
+{
+	Forget(h);
+
+	// Blank it rather than erase, so the other indices stay valid until
+	// Flush. An order to h later this tick takes the same place again.
+	if (m_PendingSlots.empty())
+		return;
+	const PendingSlot& slot = FindPending(h);
+	if (slot.stamp == m_PendingStamp)
+		m_Pending[slot.index].me = 0;
+}
+
+void OrderBuffer::Forget(Handle h)
+{
+	if (SentOrder* sent = FindSent(h, m_Sent.size()))
+		m_Sent.erase(m_Sent.begin() + (sent - m_Sent.data()));
+}
+
+void OrderBuffer::Clear()
+{
+	ClearPending();
+	m_Sent.clear();
+}
+
+void OrderBuffer::Push(const Order& order)
+{
+	if (order.me == 0)
+		return;
+
+	++m_Stats.issued;
+
+	// Kept at most half full
+	if ((m_Pending.size() + 1) * 2 > m_PendingSlots.size())
+		GrowPending();
+
+	PendingSlot& slot = FindPending(order.me);
+	if (slot.stamp != m_PendingStamp)
+	{
+		slot = { order.me, m_PendingStamp, static_cast<uint32_t>(m_Pending.size()) };
+		m_Pending.push_back(order);
+		return;
+	}
+
+	// Taking the place of an order to a unit removed this tick isn't a replacement
+	if (m_Pending[slot.index].me != 0)
+		++m_Stats.coalesced;
+	m_Pending[slot.index] = order;
+}
+
+OrderBuffer::PendingSlot& OrderBuffer::FindPending(Handle h)
+{
+	const size_t mask = m_PendingSlots.size() - 1;
+	size_t i = (static_cast<uint32_t>(h) * 2654435769u) & mask;
+	while (m_PendingSlots[i].stamp == m_PendingStamp && m_PendingSlots[i].me != h)
+		i = (i + 1) & mask;
+	return m_PendingSlots[i];
+}
+
+void OrderBuffer::GrowPending()
+{
+	m_PendingSlots.assign(std::max<size_t>(64, m_PendingSlots.size() * 2), PendingSlot{ 0, 0, 0 });
+	m_PendingStamp = 1;
+	for (uint32_t i = 0; i < m_Pending.size(); ++i)
+	{
+		// Removed ones can go, their place in m_Pending stays blank
+		if (m_Pending[i].me != 0)
+			FindPending(m_Pending[i].me) = { m_Pending[i].me, m_PendingStamp, i };
+	}
+}
+
+void OrderBuffer::ClearPending()
+{
+	m_Pending.clear();
+	if (++m_PendingStamp == 0)
+	{
+		// Wrapped, so old stamps could look current again
+		std::fill(m_PendingSlots.begin(), m_PendingSlots.end(), PendingSlot{ 0, 0, 0 });
+		m_PendingStamp = 1;
+	}
+}
+
+OrderBuffer::SentOrder* OrderBuffer::FindSent(Handle h, size_t sorted)
+{
+	const auto end = m_Sent.begin() + sorted;
+	auto it = std::lower_bound(m_Sent.begin(), end, h, [](const SentOrder& sent, Handle h)
+	{
+		return sent.order.me < h;
+	});
+	return it != end && it->order.me == h ? &*it : nullptr;
+}
+
+bool OrderBuffer::IsRedundant(const Order& order, SentOrder& sentOrder, long turn)
+{
+	const Order& sent = sentOrder.order;
+	if (sent.type != order.type || sent.cmd != order.cmd || sent.priority != order.priority
+		|| sent.param != order.param || sent.who != order.who || sent.path != order.path)
+		return false;
+
+	// Only XZ, the game snaps positional orders to the terrain
+	const bool hasWhere = order.type == ORDER_GOTO_POSITION || order.type == ORDER_COMMAND_WHERE;
+	if (hasWhere)
+	{
+		const float dx = sent.where.x - order.where.x;
+		const float dz = sent.where.z - order.where.z;
+		if (dx * dx + dz * dz > m_ToleranceSq)
+			return false;
+	}
+
+	if (turn < sentOrder.recheckTurn)
+		return true;
+
+	// Same as what we sent, but the unit may have finished it or been
+	// given something else by the game or the player since
+	++m_Stats.rechecked;
+	if (GetCurrentCommand(order.me) != order.cmd)
+		return false;
+	if (order.who != 0 && GetCurrentWho(order.me) != order.who)
+		return false;
+	if (hasWhere)
+	{
+		const Vector where = GetCurrentCommandWhere(order.me);
+		const float dx = where.x - sent.where.x;
+		const float dz = where.z - sent.where.z;
+		if (dx * dx + dz * dz > m_ToleranceSq)
+			return false;
+	}
+	sentOrder.recheckTurn = turn + m_RecheckTurns;
+	return true;
+}
+
+uint32_t OrderBuffer::InternPath(ConstName name)
+{
+	if (!name)
+		return NO_PATH;
+
+	auto it = m_PathIds.find(std::string_view(name));
+	if (it != m_PathIds.end())
+		return it->second;
+
+	const uint32_t path = static_cast<uint32_t>(m_PathNames.size());
+	m_PathIds.emplace(m_PathNames.emplace_back(name), path);
+	return path;
+}
+
+void OrderBuffer::Send(const Order& order) const
+{
+	switch (order.type)
+	{
+	case ORDER_GOTO_POSITION:
+		::Goto(order.me, order.where, order.priority);
+		break;
+	case ORDER_GOTO_HANDLE:
+		::Goto(order.me, order.who, order.priority);
+		break;
+	case ORDER_GOTO_PATH:
+		::Goto(order.me, PathName(order.path), order.priority);
+		break;
+	case ORDER_ATTACK:
+		::Attack(order.me, order.who, order.priority);
+		break;
+	case ORDER_FOLLOW:
+		::Follow(order.me, order.who, order.priority);
+		break;
+	case ORDER_DEFEND:
+		::Defend(order.me, order.priority);
+		break;
+	case ORDER_PATROL:
+		::Patrol(order.me, PathName(order.path), order.priority);
+		break;
+	case ORDER_COMMAND_WHERE:
+		::SetCommand(order.me, order.cmd, order.priority, order.who, order.where, order.param);
+		break;
+	case ORDER_COMMAND_PATH:
+		::SetCommand(order.me, order.cmd, order.priority, order.who, PathName(order.path), order.param);
+		break;
+	}
+}
@@ -0,0 +1,167 @@
+#ifndef _OrderBuffer_
+#define _OrderBuffer_
+
+#include <ScriptUtils.h>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Collects unit orders issued during Update and sends them to the game in
+// one pass at the end of the tick, dropping the ones that wouldn't change
+// anything. Each order the game receives resets the unit's pathing, so
+// scripts that re-issue the same Goto every tick "just to be safe" make
+// units stutter as well as costing an export call.
+//
+// - Several orders to the same unit in one tick collapse to the last one,
+//   which is what the game would have ended up doing anyway.
+// - An order identical to the last one we sent that unit is dropped. That
+//   check is against what we sent, so it costs no export calls. Every few
+//   turns (SetRecheckTurns) a repeat is also checked against the unit's
+//   live GetCurrentCommand/Who/CommandWhere. If the unit has finished or
+//   been given other orders, the order goes through again.
+//
+// Path names are copied into a pool the first time they're seen, so the
+// caller's string only has to live for the call. The per-unit tables keep
+// their storage, so a steady tick doesn't allocate.
+class OrderBuffer
+{
+public:
+	// Same parameters as the exports of the same name.
+	void Goto(Handle me, const Vector& pos, int priority = 1);
+	void Goto(Handle me, Handle him, int priority = 1);
+	void Goto(Handle me, ConstName path, int priority = 1);
+	void Attack(Handle me, Handle him, int priority = 1);
+	void Follow(Handle me, Handle him, int priority = 1);
+	void Defend(Handle me, int priority = 1);
+	void Patrol(Handle me, ConstName path, int priority = 1);
+	void SetCommand(Handle me, int cmd, int priority, Handle who, const Vector& where, int param = 0);
+	void SetCommand(Handle me, int cmd, int priority = 0, Handle who = 0, ConstName path = nullptr, int param = 0);
+
+	// Sends every order that changes something. Call once at the end of
+	// Update with the current turn.
+	void Flush(long turn);
+
+	// Forgets h. Call from DeleteObject.
+	void Remove(Handle h);
+
+	// Forgets what was last sent to h, so the next order goes out even if
+	// it's the same one. For when the order is the same but what it refers
+	// to isn't, like a path rewritten under the same name.
+	void Forget(Handle h);
+
+	// Drops everything, pending and sent. Call from PostLoad since handles change.
+	void Clear();
+
+	// Two positional orders closer than this count as the same order.
+	void SetPositionTolerance(float meters) { m_ToleranceSq = meters * meters; }
+
+	// How many turns a repeated order is dropped for before it's checked
+	// against the unit's live command again. A unit that finishes early can
+	// sit idle for up to this long. 0 checks every repeat.
+	void SetRecheckTurns(int turns) { m_RecheckTurns = turns; }
+
+	struct Stats
+	{
+		// Orders handed to the buffer
+		uint64_t issued;
+		// Replaced by a later order to the same unit in the same tick
+		uint64_t coalesced;
+		// Dropped because the unit was already doing it
+		uint64_t suppressed;
+		// Repeats checked against the unit's live command
+		uint64_t rechecked;
+		// Actually sent to the game
+		uint64_t flushed;
+	};
+
+	const Stats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = {}; }
+
+private:
+	enum OrderType : uint8_t
+	{
+		ORDER_GOTO_POSITION,
+		ORDER_GOTO_HANDLE,
+		ORDER_GOTO_PATH,
+		ORDER_ATTACK,
+		ORDER_FOLLOW,
+		ORDER_DEFEND,
+		ORDER_PATROL,
+		ORDER_COMMAND_WHERE,
+		ORDER_COMMAND_PATH,
+	};
+
+	struct Order
+	{
+		Handle me;
+		OrderType type;
+		int cmd;
+		int priority;
+		int param;
+		Handle who;
+		Vector where;
+		// Index into m_PathNames, or NO_PATH
+		uint32_t path;
+	};
+
+	static constexpr uint32_t NO_PATH = 0xFFFFFFFF;
+
+	struct SentOrder
+	{
+		Order order;
+		// Turn the repeat check next asks the game
+		long recheckTurn;
+	};
+
+	// Open addressing, handle to index in m_Pending. Slots whose stamp isn't
+	// m_PendingStamp are empty, so Flush empties the table with one increment.
+	struct PendingSlot
+	{
+		Handle me;
+		uint32_t stamp;
+		uint32_t index;
+	};
+
+	// Pool index for name, adding it if it's new
+	uint32_t InternPath(ConstName name);
+
+	void Push(const Order& order);
+
+	// Slot for h, either holding it or the empty one where it would go
+	PendingSlot& FindPending(Handle h);
+	void GrowPending();
+	void ClearPending();
+
+	// m_Sent entry for h among the first sorted entries, or nullptr
+	SentOrder* FindSent(Handle h, size_t sorted);
+
+	// True if order is the same as the last one sent and the unit is
+	// still on it, as of the last live check.
+	bool IsRedundant(const Order& order, SentOrder& sent, long turn);
+
+	void Send(const Order& order) const;
+
+	ConstName PathName(uint32_t path) const { return path != NO_PATH ? m_PathNames[path].c_str() : nullptr; }
+
+	std::vector<Order> m_Pending;
+	std::vector<PendingSlot> m_PendingSlots;
+	uint32_t m_PendingStamp = 1;
+
+	// Last order sent to each unit, sorted by handle
+	std::vector<SentOrder> m_Sent;
+
+	// Every path name ordered so far. A deque so the lookup keys stay put;
+	// names don't depend on handles, so Clear keeps them.
+	std::deque<std::string> m_PathNames;
+	std::unordered_map<std::string_view, uint32_t> m_PathIds;
+
+	float m_ToleranceSq = 1.0f;
+	int m_RecheckTurns = 10;
+	Stats m_Stats{};
+};
+
+#endif
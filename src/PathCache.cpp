@@ -0,0 +1,244 @@
+#include "PathCache.h"
+
+#include "ExportBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Closest point to (px, pz) on the segment a-b, as a fraction along it
+	float ProjectOnSegment(const VECTOR_2D& a, const VECTOR_2D& b, float px, float pz)
+	{
+		const float dx = b.x - a.x;
+		const float dz = b.z - a.z;
+		const float lengthSq = dx * dx + dz * dz;
+		if (lengthSq <= 0.0f)
+			return 0.0f;
+		const float t = ((px - a.x) * dx + (pz - a.z) * dz) / lengthSq;
+		return std::clamp(t, 0.0f, 1.0f);
+	}
+}
+
+void PathCache::Load()
+{
+	m_Paths.clear();
+	m_Points.clear();
+	m_Distances.clear();
+	m_Names.clear();
+	m_Lookup.clear();
+	m_Stale = false;
+
+	int pathCount = 0;
+	char** pathNames = nullptr;
+	GetAiPaths(pathCount, pathNames);
+	if (pathCount <= 0 || !pathNames)
+		return;
+
+	m_Paths.reserve(pathCount);
+	for (int i = 0; i < pathCount; ++i)
+	{
+		ConstName name = pathNames[i];
+		if (!name)
+			continue;
+
+		// One call per path once the buffer fits the longest one
+		const std::span<const VECTOR_2D> points = QueryPathPoints(m_PathPoints, name);
+		if (points.empty())
+			continue;
+
+		const size_t first = m_Points.size();
+		const size_t count = points.size();
+		m_Points.insert(m_Points.end(), points.begin(), points.end());
+
+		Path path{};
+		path.nameOffset = static_cast<uint32_t>(m_Names.size());
+		path.first = static_cast<uint32_t>(first);
+		path.count = static_cast<uint32_t>(count);
+		path.minX = path.maxX = m_Points[first].x;
+		path.minZ = path.maxZ = m_Points[first].z;
+
+		float distance = 0.0f;
+		m_Distances.push_back(0.0f);
+		for (size_t p = first + 1; p < first + count; ++p)
+		{
+			const VECTOR_2D& a = m_Points[p - 1];
+			const VECTOR_2D& b = m_Points[p];
+			distance += std::sqrt((b.x - a.x) * (b.x - a.x) + (b.z - a.z) * (b.z - a.z));
+			m_Distances.push_back(distance);
+
+			path.minX = std::min(path.minX, b.x);
+			path.maxX = std::max(path.maxX, b.x);
+			path.minZ = std::min(path.minZ, b.z);
+			path.maxZ = std::max(path.maxZ, b.z);
+		}
+
+		m_Names.append(name);
+		m_Names.push_back('\0');
+		m_Paths.push_back(path);
+	}
+
+	// Only now that m_Names is done growing
+	m_Lookup.reserve(m_Paths.size());
+	for (uint32_t i = 0; i < m_Paths.size(); ++i)
+		m_Lookup.emplace(std::string_view(m_Names.data() + m_Paths[i].nameOffset), i);
+}
+
+bool PathCache::CreatePath(ConstName name, float x, float z)
+{
+	m_Stale = true;
+	return ::CreatePath(name, x, z);
+}
+
+int PathCache::AddPathPoint(ConstName name, float x, float z)
+{
+	m_Stale = true;
+	return ::AddPathPoint(name, x, z);
+}
+
+bool PathCache::SetPathPoint(ConstName name, int point, float x, float z)
+{
+	m_Stale = true;
+	return ::SetPathPoint(name, point, x, z);
+}
+
+int PathCache::RemovePathPoint(ConstName name, int point)
+{
+	m_Stale = true;
+	return ::RemovePathPoint(name, point);
+}
+
+bool PathCache::RenamePath(ConstName oldName, ConstName newName)
+{
+	m_Stale = true;
+	return ::RenamePath(oldName, newName);
+}
+
+bool PathCache::RemovePath(ConstName name)
+{
+	m_Stale = true;
+	return ::RemovePath(name);
+}
+
+bool PathCache::HasPath(ConstName path)
+{
+	return Find(path) != nullptr;
+}
+
+std::span<const VECTOR_2D> PathCache::GetPoints(ConstName path)
+{
+	const Path* p = Find(path);
+	if (!p)
+		return {};
+	return GetPoints(*p);
+}
+
+float PathCache::GetLength(ConstName path)
+{
+	const Path* p = Find(path);
+	if (!p)
+		return 0.0f;
+	return m_Distances[p->first + p->count - 1];
+}
+
+bool PathCache::FindNearest(ConstName path, const Vector& pos, Nearest& out)
+{
+	const Path* p = Find(path);
+	if (!p)
+		return false;
+
+	const std::span<const VECTOR_2D> points = GetPoints(*p);
+
+	// Single point paths have no segments
+	out = { points[0], 0, 0.0f, 0.0f, 0.0f };
+	float bestSq = (pos.x - points[0].x) * (pos.x - points[0].x) + (pos.z - points[0].z) * (pos.z - points[0].z);
+
+	for (size_t i = 0; i + 1 < points.size(); ++i)
+	{
+		const VECTOR_2D& a = points[i];
+		const VECTOR_2D& b = points[i + 1];
+		const float t = ProjectOnSegment(a, b, pos.x, pos.z);
+		const float x = a.x + (b.x - a.x) * t;
+		const float z = a.z + (b.z - a.z) * t;
+		const float distSq = (pos.x - x) * (pos.x - x) + (pos.z - z) * (pos.z - z);
+		if (distSq < bestSq)
+		{
+			bestSq = distSq;
+			out.point = VECTOR_2D(x, z);
+			out.segment = static_cast<int>(i);
+			out.t = t;
+		}
+	}
+
+	out.distance = std::sqrt(bestSq);
+	const float* distances = m_Distances.data() + p->first;
+	out.progress = points.size() > 1
+		? distances[out.segment] + (distances[out.segment + 1] - distances[out.segment]) * out.t
+		: 0.0f;
+	return true;
+}
+
+float PathCache::GetDistance(ConstName path, const Vector& pos)
+{
+	Nearest nearest;
+	if (!FindNearest(path, pos, nearest))
+		return -1.0f;
+	return nearest.distance;
+}
+
+float PathCache::GetDistanceToSegment(ConstName path, int segment, const Vector& pos)
+{
+	const Path* p = Find(path);
+	if (!p || segment < 0 || static_cast<uint32_t>(segment) + 1 >= p->count)
+		return -1.0f;
+
+	const VECTOR_2D& a = m_Points[p->first + segment];
+	const VECTOR_2D& b = m_Points[p->first + segment + 1];
+	const float t = ProjectOnSegment(a, b, pos.x, pos.z);
+	const float dx = pos.x - (a.x + (b.x - a.x) * t);
+	const float dz = pos.z - (a.z + (b.z - a.z) * t);
+	return std::sqrt(dx * dx + dz * dz);
+}
+
+float PathCache::GetProgress(ConstName path, const Vector& pos)
+{
+	Nearest nearest;
+	if (!FindNearest(path, pos, nearest))
+		return -1.0f;
+	return nearest.progress;
+}
+
+bool PathCache::IsInside(ConstName path, const Vector& pos)
+{
+	const Path* p = Find(path);
+	if (!p || p->count < 3)
+		return false;
+	if (pos.x < p->minX || pos.x > p->maxX || pos.z < p->minZ || pos.z > p->maxZ)
+		return false;
+
+	// Even-odd crossing test
+	const std::span<const VECTOR_2D> points = GetPoints(*p);
+	bool inside = false;
+	for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+	{
+		const VECTOR_2D& a = points[i];
+		const VECTOR_2D& b = points[j];
+		if ((a.z > pos.z) != (b.z > pos.z)
+			&& pos.x < (b.x - a.x) * (pos.z - a.z) / (b.z - a.z) + a.x)
+			inside = !inside;
+	}
+	return inside;
+}
+
+const PathCache::Path* PathCache::Find(ConstName path)
+{
+	if (!path)
+		return nullptr;
+
+	Update();
+
+	auto it = m_Lookup.find(std::string_view(path));
+	if (it == m_Lookup.end())
+		return nullptr;
+	return &m_Paths[it->second];
+}
@@ -0,0 +1,122 @@
+#ifndef _PathCache_
+#define _PathCache_
+
+#include <ScriptUtils.h>
+
+#include "ExportBuffer.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Copy of every AI path on the map, with the polyline queries scripts
+// otherwise do with GetDistance(h, path, point) one point at a time.
+//
+// Load pulls the names from GetAiPaths and the points from GetPathPoints
+// into one contiguous array, each path a range of it. Paths changed from
+// script have to go through the wrappers below (same parameters as the
+// exports), which mark the cache stale; it reloads on the next query.
+//
+// Everything is 2D (XZ) like the paths themselves. Spans returned from
+// here are valid until the next reload.
+class PathCache
+{
+public:
+	// Reads every path from the game. Call from InitialSetup.
+	void Load();
+
+	// Makes the next query reload. Call from PostLoad.
+	void Invalidate() { m_Stale = true; }
+
+	bool CreatePath(ConstName name, float x, float z);
+	int AddPathPoint(ConstName name, float x, float z);
+	bool SetPathPoint(ConstName name, int point, float x, float z);
+	int RemovePathPoint(ConstName name, int point);
+	bool RenamePath(ConstName oldName, ConstName newName);
+	bool RemovePath(ConstName name);
+
+	bool HasPath(ConstName path);
+
+	// Empty if the path doesn't exist
+	std::span<const VECTOR_2D> GetPoints(ConstName path);
+
+	// Length of the path from first to last point
+	float GetLength(ConstName path);
+
+	struct Nearest
+	{
+		// Closest point on the path
+		VECTOR_2D point;
+		// Segment it's on (from point segment to segment + 1) and how far along it, 0 to 1
+		int segment;
+		float t;
+		float distance;
+		// Distance along the path from the first point to point
+		float progress;
+	};
+
+	// Closest point on the path to pos. False if the path doesn't exist.
+	bool FindNearest(ConstName path, const Vector& pos, Nearest& out);
+
+	// Distance from pos to the path, or -1 if the path doesn't exist.
+	float GetDistance(ConstName path, const Vector& pos);
+
+	// Distance from pos to one segment of the path, or -1 if the path or
+	// segment doesn't exist.
+	float GetDistanceToSegment(ConstName path, int segment, const Vector& pos);
+
+	// How far along the path the closest point to pos is, or -1 if the
+	// path doesn't exist.
+	float GetProgress(ConstName path, const Vector& pos);
+
+	// Treats the path as a closed polygon (last point back to the first),
+	// like area paths. False for paths with fewer than 3 points.
+	bool IsInside(ConstName path, const Vector& pos);
+
+	size_t GetPathCount() { Update(); return m_Paths.size(); }
+
+private:
+	struct Path
+	{
+		uint32_t nameOffset;
+		uint32_t first;
+		uint32_t count;
+		float minX, minZ, maxX, maxZ;
+	};
+
+	void Update()
+	{
+		if (m_Stale)
+			Load();
+	}
+
+	// Updates the cache if needed and returns the path, or nullptr
+	const Path* Find(ConstName path);
+
+	std::span<const VECTOR_2D> GetPoints(const Path& path) const
+	{
+		return { m_Points.data() + path.first, path.count };
+	}
+
+	std::vector<Path> m_Paths;
+
+	// Points of every path back to back, and the distance along its path
+	// to each one
+	std::vector<VECTOR_2D> m_Points;
+	std::vector<float> m_Distances;
+
+	// Names back to back with their terminators, so the lookup keys can
+	// point into it
+	std::string m_Names;
+	std::unordered_map<std::string_view, uint32_t> m_Lookup;
+
+	// GetPathPoints lands here before it's copied into m_Points
+	ExportBuffer<VECTOR_2D> m_PathPoints;
+
+	bool m_Stale = true;
+};
+
+#endif
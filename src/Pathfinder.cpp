@@ -0,0 +1,505 @@
+#include "Pathfinder.h"
+
+#include "PathCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace
+{
+	constexpr float SQRT2 = 1.41421356f;
+
+	// How far FindCell looks for a passable cell, in cells
+	constexpr int SNAP_RADIUS = 4;
+
+	// Neighbours, the four straight ones first
+	constexpr int DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	constexpr int DZ[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	// Octile distance in cells, admissible since no cell costs less than flat ground
+	float Octile(int dx, int dz)
+	{
+		dx = std::abs(dx);
+		dz = std::abs(dz);
+		return static_cast<float>(std::max(dx, dz) - std::min(dx, dz)) + SQRT2 * static_cast<float>(std::min(dx, dz));
+	}
+
+	// Min-heap on f
+	constexpr auto OpenGreater = [](const auto& a, const auto& b) { return a.f > b.f; };
+}
+
+void Pathfinder::Build(const Settings& settings)
+{
+	m_Settings = settings;
+	m_Settings.clusterSize = std::max(settings.clusterSize, 2);
+
+	const float cellSize = settings.cellSize;
+	m_MinX = GetTerrainMinX();
+	m_MinZ = GetTerrainMinZ();
+	m_Width = std::max(1, static_cast<int>(std::ceil((GetTerrainMaxX() - m_MinX) / cellSize)));
+	m_Height = std::max(1, static_cast<int>(std::ceil((GetTerrainMaxZ() - m_MinZ) / cellSize)));
+
+	const size_t cellCount = static_cast<size_t>(m_Width) * m_Height;
+	m_Cost.assign(cellCount, BLOCKED);
+	m_Heights.assign(cellCount, 0.0f);
+
+	for (int z = 0; z < m_Height; ++z)
+	{
+		for (int x = 0; x < m_Width; ++x)
+		{
+			const int cell = CellIndex(x, z);
+			const Vector pos(m_MinX + (x + 0.5f) * cellSize, 0.0f, m_MinZ + (z + 0.5f) * cellSize);
+
+			float height = 0.0f;
+			Vector normal(0.0f, 1.0f, 0.0f);
+			if (!TerrainGetHeightAndNormal(pos, height, normal, false))
+				continue;
+			m_Heights[cell] = height;
+
+			if (normal.y <= 0.0f)
+				continue;
+			const float slope = std::sqrt(std::max(0.0f, 1.0f - normal.y * normal.y)) / normal.y;
+			if (slope > settings.maxSlope)
+				continue;
+
+			float cost = 1.0f;
+			if (settings.maxSlope > 0.0f)
+				cost += settings.slopeCost * slope / settings.maxSlope;
+			if (TerrainIsWater(pos.x, pos.z))
+			{
+				if (settings.waterCost <= 0.0f)
+					continue;
+				cost *= settings.waterCost;
+			}
+
+			// Never cheaper than flat ground, the heuristic depends on it
+			m_Cost[cell] = static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround(cost * COST_ONE)), COST_ONE, 255));
+		}
+	}
+
+	m_G.assign(cellCount, 0.0f);
+	m_Parent.assign(cellCount, -1);
+	m_Seen.assign(cellCount, 0);
+	m_Closed.assign(cellCount, 0);
+	m_Stamp = 0;
+
+	BuildClusterGraph();
+	m_Cache.clear();
+}
+
+bool Pathfinder::FindPath(const Vector& start, const Vector& goal, std::vector<Vector>& waypoints)
+{
+	waypoints.clear();
+	if (!IsBuilt())
+		Build();
+
+	++m_Stats.queries;
+
+	const int startCell = FindCell(start);
+	const int goalCell = FindCell(goal);
+	if (startCell < 0 || goalCell < 0)
+		return false;
+
+	const uint64_t key = (static_cast<uint64_t>(startCell) << 32) | static_cast<uint32_t>(goalCell);
+	auto it = m_Cache.find(key);
+	if (it != m_Cache.end())
+	{
+		++m_Stats.cacheHits;
+		waypoints = it->second;
+	}
+	else
+	{
+		std::pmr::vector<int> cells{ m_Scratch };
+		const int startCluster = ClusterOf(startCell);
+		const int goalCluster = ClusterOf(goalCell);
+		const bool near = std::abs(startCluster % m_ClustersX - goalCluster % m_ClustersX) <= 1
+			&& std::abs(startCluster / m_ClustersX - goalCluster / m_ClustersX) <= 1;
+
+		bool found;
+		if (near)
+		{
+			found = Search(startCell, goalCell, { 0, 0, m_Width, m_Height }, &cells) >= 0.0f;
+		}
+		else
+		{
+			++m_Stats.abstractSearches;
+			found = SearchClusters(startCell, goalCell, cells);
+		}
+
+		if (found)
+			MakeWaypoints(cells, waypoints);
+
+		// Failures are cached too, they're the searches that visit the most cells
+		if (m_Cache.size() >= MAX_CACHED_PATHS)
+			m_Cache.clear();
+		m_Cache.emplace(key, waypoints);
+	}
+
+	if (waypoints.empty())
+		return false;
+
+	waypoints.front() = start;
+	waypoints.back() = goal;
+	return true;
+}
+
+bool Pathfinder::CreateGamePath(PathCache& paths, ConstName name, std::span<const Vector> waypoints)
+{
+	if (!name || waypoints.empty())
+		return false;
+
+	paths.RemovePath(name);
+	if (!paths.CreatePath(name, waypoints[0].x, waypoints[0].z))
+		return false;
+	for (size_t i = 1; i < waypoints.size(); ++i)
+	{
+		if (paths.AddPathPoint(name, waypoints[i].x, waypoints[i].z) < 0)
+			return false;
+	}
+	return true;
+}
+
+bool Pathfinder::IsPassable(const Vector& pos) const
+{
+	if (!IsBuilt())
+		return false;
+
+	const int x = static_cast<int>(std::floor((pos.x - m_MinX) / m_Settings.cellSize));
+	const int z = static_cast<int>(std::floor((pos.z - m_MinZ) / m_Settings.cellSize));
+	if (x < 0 || z < 0 || x >= m_Width || z >= m_Height)
+		return false;
+	return m_Cost[CellIndex(x, z)] != BLOCKED;
+}
+
+int Pathfinder::ClusterOf(int cell) const
+{
+	const int x = cell % m_Width;
+	const int z = cell / m_Width;
+	return (z / m_Settings.clusterSize) * m_ClustersX + x / m_Settings.clusterSize;
+}
+
+Pathfinder::Bounds Pathfinder::ClusterBounds(int cluster) const
+{
+	const int size = m_Settings.clusterSize;
+	const int x0 = (cluster % m_ClustersX) * size;
+	const int z0 = (cluster / m_ClustersX) * size;
+	return { x0, z0, std::min(x0 + size, m_Width), std::min(z0 + size, m_Height) };
+}
+
+Vector Pathfinder::CellCenter(int cell) const
+{
+	const int x = cell % m_Width;
+	const int z = cell / m_Width;
+	return Vector(m_MinX + (x + 0.5f) * m_Settings.cellSize, m_Heights[cell], m_MinZ + (z + 0.5f) * m_Settings.cellSize);
+}
+
+int Pathfinder::FindCell(const Vector& pos) const
+{
+	const int cx = std::clamp(static_cast<int>(std::floor((pos.x - m_MinX) / m_Settings.cellSize)), 0, m_Width - 1);
+	const int cz = std::clamp(static_cast<int>(std::floor((pos.z - m_MinZ) / m_Settings.cellSize)), 0, m_Height - 1);
+	if (m_Cost[CellIndex(cx, cz)] != BLOCKED)
+		return CellIndex(cx, cz);
+
+	// Closest passable cell in a growing square
+	for (int r = 1; r <= SNAP_RADIUS; ++r)
+	{
+		int best = -1;
+		int bestDistSq = std::numeric_limits<int>::max();
+		for (int z = std::max(cz - r, 0); z <= std::min(cz + r, m_Height - 1); ++z)
+		{
+			for (int x = std::max(cx - r, 0); x <= std::min(cx + r, m_Width - 1); ++x)
+			{
+				const int distSq = (x - cx) * (x - cx) + (z - cz) * (z - cz);
+				if (m_Cost[CellIndex(x, z)] != BLOCKED && distSq < bestDistSq)
+				{
+					best = CellIndex(x, z);
+					bestDistSq = distSq;
+				}
+			}
+		}
+		if (best >= 0)
+			return best;
+	}
+	return -1;
+}
+
+void Pathfinder::BuildClusterGraph()
+{
+	const int size = m_Settings.clusterSize;
+	m_ClustersX = (m_Width + size - 1) / size;
+	m_ClustersZ = (m_Height + size - 1) / size;
+
+	m_Nodes.clear();
+	m_Edges.clear();
+	m_NodeByCell.clear();
+	m_ClusterNodes.assign(static_cast<size_t>(m_ClustersX) * m_ClustersZ, {});
+
+	auto connect = [this](int a, int b)
+	{
+		const int na = AddNode(a);
+		const int nb = AddNode(b);
+		const float cost = static_cast<float>(m_Cost[a] + m_Cost[b]) / (2.0f * COST_ONE);
+		m_Edges[na].push_back({ nb, cost });
+		m_Edges[nb].push_back({ na, cost });
+	};
+
+	// One entrance in the middle of every open stretch of a cluster border.
+	// cellsAt(i) gives the pair of cells facing each other at step i along it.
+	auto scanBorder = [&](int length, auto cellsAt)
+	{
+		int runStart = -1;
+		for (int i = 0; i < length; ++i)
+		{
+			const auto [a, b] = cellsAt(i);
+			const bool open = m_Cost[a] != BLOCKED && m_Cost[b] != BLOCKED;
+			if (open && runStart < 0)
+				runStart = i;
+
+			// Runs also stop at cluster corners so each entrance has one pair of clusters
+			const bool runEnds = !open || i + 1 == length || (i + 1) % size == 0;
+			if (runStart >= 0 && runEnds)
+			{
+				const int mid = (runStart + (open ? i : i - 1)) / 2;
+				const auto [ma, mb] = cellsAt(mid);
+				connect(ma, mb);
+				runStart = -1;
+			}
+		}
+	};
+
+	for (int x = size; x < m_Width; x += size)
+		scanBorder(m_Height, [&](int z) { return std::make_pair(CellIndex(x - 1, z), CellIndex(x, z)); });
+	for (int z = size; z < m_Height; z += size)
+		scanBorder(m_Width, [&](int x) { return std::make_pair(CellIndex(x, z - 1), CellIndex(x, z)); });
+
+	// Routes between the entrances of each cluster, staying inside it
+	for (size_t cluster = 0; cluster < m_ClusterNodes.size(); ++cluster)
+	{
+		const std::vector<int>& nodes = m_ClusterNodes[cluster];
+		const Bounds bounds = ClusterBounds(static_cast<int>(cluster));
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			for (size_t j = i + 1; j < nodes.size(); ++j)
+			{
+				const float cost = Search(m_Nodes[nodes[i]].cell, m_Nodes[nodes[j]].cell, bounds, nullptr);
+				if (cost < 0.0f)
+					continue;
+				m_Edges[nodes[i]].push_back({ nodes[j], cost });
+				m_Edges[nodes[j]].push_back({ nodes[i], cost });
+			}
+		}
+	}
+}
+
+int Pathfinder::AddNode(int cell)
+{
+	auto [it, inserted] = m_NodeByCell.try_emplace(cell, static_cast<int>(m_Nodes.size()));
+	if (inserted)
+	{
+		const int cluster = ClusterOf(cell);
+		m_Nodes.push_back({ cell, cluster });
+		m_Edges.emplace_back();
+		m_ClusterNodes[cluster].push_back(it->second);
+	}
+	return it->second;
+}
+
+float Pathfinder::Search(int start, int goal, const Bounds& bounds, std::pmr::vector<int>* cells)
+{
+	if (++m_Stamp == 0)
+	{
+		std::fill(m_Seen.begin(), m_Seen.end(), 0);
+		std::fill(m_Closed.begin(), m_Closed.end(), 0);
+		m_Stamp = 1;
+	}
+
+	const int goalX = goal % m_Width;
+	const int goalZ = goal / m_Width;
+
+	m_Open.clear();
+	m_G[start] = 0.0f;
+	m_Parent[start] = -1;
+	m_Seen[start] = m_Stamp;
+	m_Open.push_back({ Octile(start % m_Width - goalX, start / m_Width - goalZ), start });
+
+	while (!m_Open.empty())
+	{
+		std::pop_heap(m_Open.begin(), m_Open.end(), OpenGreater);
+		const int cell = m_Open.back().id;
+		m_Open.pop_back();
+
+		if (m_Closed[cell] == m_Stamp)
+			continue;
+		m_Closed[cell] = m_Stamp;
+
+		if (cell == goal)
+		{
+			if (cells)
+			{
+				const size_t first = cells->size();
+				for (int c = goal; c != -1; c = m_Parent[c])
+					cells->push_back(c);
+				std::reverse(cells->begin() + first, cells->end());
+			}
+			return m_G[goal];
+		}
+
+		const int x = cell % m_Width;
+		const int z = cell / m_Width;
+		for (int k = 0; k < 8; ++k)
+		{
+			const int nx = x + DX[k];
+			const int nz = z + DZ[k];
+			if (nx < bounds.x0 || nz < bounds.z0 || nx >= bounds.x1 || nz >= bounds.z1)
+				continue;
+
+			const int next = CellIndex(nx, nz);
+			if (m_Cost[next] == BLOCKED || m_Closed[next] == m_Stamp)
+				continue;
+
+			// No cutting corners past blocked cells
+			if (k >= 4 && (m_Cost[CellIndex(nx, z)] == BLOCKED || m_Cost[CellIndex(x, nz)] == BLOCKED))
+				continue;
+
+			const float step = (k < 4 ? 1.0f : SQRT2) * static_cast<float>(m_Cost[cell] + m_Cost[next]) / (2.0f * COST_ONE);
+			const float g = m_G[cell] + step;
+			if (m_Seen[next] != m_Stamp || g < m_G[next])
+			{
+				m_Seen[next] = m_Stamp;
+				m_G[next] = g;
+				m_Parent[next] = cell;
+				m_Open.push_back({ g + Octile(nx - goalX, nz - goalZ), next });
+				std::push_heap(m_Open.begin(), m_Open.end(), OpenGreater);
+			}
+		}
+	}
+
+	return -1.0f;
+}
+
+bool Pathfinder::SearchClusters(int start, int goal, std::pmr::vector<int>& cells)
+{
+	const int startCluster = ClusterOf(start);
+	const int goalCluster = ClusterOf(goal);
+	const int nodeCount = static_cast<int>(m_Nodes.size());
+
+	// start and goal join the graph for this search only, linked to the
+	// entrances of their own clusters
+	const int START = nodeCount;
+	const int GOAL = nodeCount + 1;
+
+	std::pmr::vector<Edge> startLinks{ m_Scratch };
+	for (int node : m_ClusterNodes[startCluster])
+	{
+		const float cost = Search(start, m_Nodes[node].cell, ClusterBounds(startCluster), nullptr);
+		if (cost >= 0.0f)
+			startLinks.push_back({ node, cost });
+	}
+
+	std::pmr::vector<float> goalLinks(nodeCount, -1.0f, m_Scratch);
+	bool anyGoalLink = false;
+	for (int node : m_ClusterNodes[goalCluster])
+	{
+		goalLinks[node] = Search(m_Nodes[node].cell, goal, ClusterBounds(goalCluster), nullptr);
+		anyGoalLink |= goalLinks[node] >= 0.0f;
+	}
+
+	if (startLinks.empty() || !anyGoalLink)
+		return false;
+
+	const int goalX = goal % m_Width;
+	const int goalZ = goal / m_Width;
+	auto heuristic = [&](int node)
+	{
+		const int cell = node == START ? start : m_Nodes[node].cell;
+		return Octile(cell % m_Width - goalX, cell / m_Width - goalZ);
+	};
+
+	std::pmr::vector<float> g(nodeCount + 2, std::numeric_limits<float>::infinity(), m_Scratch);
+	std::pmr::vector<int> parent(nodeCount + 2, -1, m_Scratch);
+	std::pmr::vector<bool> closed(nodeCount + 2, false, m_Scratch);
+	std::pmr::vector<OpenEntry> open{ m_Scratch };
+
+	g[START] = 0.0f;
+	open.push_back({ heuristic(START), START });
+
+	auto relax = [&](int from, int to, float cost)
+	{
+		const float next = g[from] + cost;
+		if (closed[to] || next >= g[to])
+			return;
+		g[to] = next;
+		parent[to] = from;
+		open.push_back({ next + (to == GOAL ? 0.0f : heuristic(to)), to });
+		std::push_heap(open.begin(), open.end(), OpenGreater);
+	};
+
+	while (!open.empty())
+	{
+		std::pop_heap(open.begin(), open.end(), OpenGreater);
+		const int node = open.back().id;
+		open.pop_back();
+
+		if (closed[node])
+			continue;
+		closed[node] = true;
+		if (node == GOAL)
+			break;
+
+		const std::span<const Edge> edges = node == START ? std::span<const Edge>(startLinks) : std::span<const Edge>(m_Edges[node]);
+		for (const Edge& edge : edges)
+			relax(node, edge.to, edge.cost);
+		if (node != START && goalLinks[node] >= 0.0f)
+			relax(node, GOAL, goalLinks[node]);
+	}
+
+	if (!closed[GOAL])
+		return false;
+
+	std::pmr::vector<int> chain{ m_Scratch };
+	for (int node = GOAL; node != -1; node = parent[node])
+		chain.push_back(node);
+	std::reverse(chain.begin(), chain.end());
+
+	// Fill in the cells. Hops between clusters are already neighbouring
+	// cells, hops inside one get searched within its bounds.
+	cells.push_back(start);
+	std::pmr::vector<int> segment{ m_Scratch };
+	int previous = start;
+	for (size_t i = 1; i < chain.size(); ++i)
+	{
+		const int cell = chain[i] == GOAL ? goal : m_Nodes[chain[i]].cell;
+		if (cell == previous)
+			continue;
+
+		if (ClusterOf(cell) != ClusterOf(previous))
+		{
+			cells.push_back(cell);
+		}
+		else
+		{
+			segment.clear();
+			if (Search(previous, cell, ClusterBounds(ClusterOf(cell)), &segment) < 0.0f)
+				return false;
+			cells.insert(cells.end(), segment.begin() + 1, segment.end());
+		}
+		previous = cell;
+	}
+	return true;
+}
+
+void Pathfinder::MakeWaypoints(std::span<const int> cells, std::vector<Vector>& waypoints) const
+{
+	waypoints.push_back(CellCenter(cells.front()));
+	for (size_t i = 1; i + 1 < cells.size(); ++i)
+	{
+		// Keep only the cells where the direction changes
+		const int in = cells[i] - cells[i - 1];
+		const int out = cells[i + 1] - cells[i];
+		if (in != out)
+			waypoints.push_back(CellCenter(cells[i]));
+	}
+	waypoints.push_back(CellCenter(cells.back()));
+}
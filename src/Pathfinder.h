@@ -0,0 +1,174 @@
+#ifndef _Pathfinder_
+#define _Pathfinder_
+
+#include <ScriptUtils.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class PathCache;
+
+// Mission-side pathfinder for when FindAiPath is too slow to call for
+// every scripted unit. The terrain is sampled once into a grid of move
+// costs (slope and water from TerrainGetHeightAndNormal/TerrainIsWater)
+// and searched with 8-way A*.
+//
+// Long routes use HPA*: the grid is split into square clusters, cells
+// where neighbouring clusters connect become nodes of a small abstract
+// graph, and a query searches that graph first, then only fills in the
+// cells cluster by cluster. Routes short enough to start and end in
+// neighbouring clusters are searched on the grid directly.
+//
+// Results are cached by (start cell, goal cell). The game's units still
+// do their own local steering, so waypoints are cell centres with the
+// straight runs collapsed; feed them to Goto one at a time, or turn them
+// into a game path with CreateGamePath.
+class Pathfinder
+{
+public:
+	// Per-search buffers come out of scratch, e.g. the mission's FrameArena
+	explicit Pathfinder(std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) : m_Scratch(scratch) {}
+
+	struct Settings
+	{
+		float cellSize = 16.0f;
+		// Cells per cluster side
+		int clusterSize = 16;
+		// Rise over run; steeper cells are impassable
+		float maxSlope = 1.0f;
+		// Extra cost at maxSlope, scaled linearly from flat ground
+		float slopeCost = 4.0f;
+		// Multiplier on water cells, 0 makes water impassable
+		float waterCost = 3.0f;
+	};
+
+	// Samples the terrain over GetTerrainMinX..MaxX/MinZ..MaxZ and builds the
+	// cluster graph. On a 4 km map that's ~65k terrain calls plus an A* per
+	// cluster entrance, far too much for one tick, so call it from
+	// InitialSetup. FindPath still builds with default settings if it hasn't.
+	void Build(const Settings& settings);
+	void Build() { Build(Settings{}); }
+
+	bool IsBuilt() const { return !m_Cost.empty(); }
+
+	// Fills waypoints with a route from start to goal, first point start
+	// and last point goal. False if there is none, in which case
+	// waypoints is left empty. An impassable start or goal snaps to the
+	// nearest passable cell within a few cells.
+	bool FindPath(const Vector& start, const Vector& goal, std::vector<Vector>& waypoints);
+
+	// Replaces the game path name with the waypoints, through the
+	// PathCache wrappers so its copy stays current. e.g.
+	//
+	// if (pathfinder.FindPath(from, to, route) && Pathfinder::CreateGamePath(pathCache, "route_1", route))
+	// {
+	//     // Same name as the last Goto, so the buffer would drop it as a repeat
+	//     orderBuffer.Forget(h);
+	//     orderBuffer.Goto(h, "route_1");
+	// }
+	static bool CreateGamePath(PathCache& paths, ConstName name, std::span<const Vector> waypoints);
+
+	bool IsPassable(const Vector& pos) const;
+
+	// Drops cached routes. Build does this too.
+	void ClearCache() { m_Cache.clear(); }
+
+	struct Stats
+	{
+		uint64_t queries;
+		uint64_t cacheHits;
+		// Queries that went through the cluster graph
+		uint64_t abstractSearches;
+	};
+
+	const Stats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = {}; }
+
+private:
+	// Cell costs are fixed point, COST_ONE is flat dry ground
+	static constexpr uint8_t BLOCKED = 0;
+	static constexpr int COST_ONE = 16;
+
+	// Routes kept before the cache is dropped and starts over
+	static constexpr size_t MAX_CACHED_PATHS = 512;
+
+	// Inclusive-exclusive cell range a search may visit
+	struct Bounds
+	{
+		int x0, z0, x1, z1;
+	};
+
+	struct Edge
+	{
+		int to;
+		float cost;
+	};
+
+	struct OpenEntry
+	{
+		float f;
+		int id;
+	};
+
+	// An entrance cell on a cluster border
+	struct Node
+	{
+		int cell;
+		int cluster;
+	};
+
+	int CellIndex(int x, int z) const { return z * m_Width + x; }
+	int ClusterOf(int cell) const;
+	Bounds ClusterBounds(int cluster) const;
+	Vector CellCenter(int cell) const;
+
+	// Nearest passable cell to pos within a few cells, or -1
+	int FindCell(const Vector& pos) const;
+
+	void BuildClusterGraph();
+	int AddNode(int cell);
+
+	// Grid A* from start to goal inside bounds. Returns the cost, or -1 if
+	// there's no route. Appends the cells (start and goal included) to
+	// cells if given.
+	float Search(int start, int goal, const Bounds& bounds, std::pmr::vector<int>* cells);
+
+	// Abstract search plus refinement. Appends the cells to cells.
+	bool SearchClusters(int start, int goal, std::pmr::vector<int>& cells);
+
+	// Turns cells into waypoints with straight runs collapsed
+	void MakeWaypoints(std::span<const int> cells, std::vector<Vector>& waypoints) const;
+
+	std::pmr::memory_resource* m_Scratch;
+	Settings m_Settings;
+	float m_MinX = 0.0f;
+	float m_MinZ = 0.0f;
+	int m_Width = 0;
+	int m_Height = 0;
+	int m_ClustersX = 0;
+	int m_ClustersZ = 0;
+
+	std::vector<uint8_t> m_Cost;
+	std::vector<float> m_Heights;
+
+	std::vector<Node> m_Nodes;
+	std::vector<std::vector<Edge>> m_Edges;
+	std::vector<std::vector<int>> m_ClusterNodes;
+	std::unordered_map<int, int> m_NodeByCell;
+
+	// Search scratch, sized to the grid. Stamps save clearing it every search.
+	std::vector<float> m_G;
+	std::vector<int> m_Parent;
+	std::vector<uint32_t> m_Seen;
+	std::vector<uint32_t> m_Closed;
+	std::vector<OpenEntry> m_Open;
+	uint32_t m_Stamp = 0;
+
+	std::unordered_map<uint64_t, std::vector<Vector>> m_Cache;
+	Stats m_Stats{};
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "PortableTrig.h"
+
+#include <algorithm>
+
+void PortableTrig::Sin(std::span<const float> angles, std::span<float> out)
+{
+	for (size_t i = 0; i < angles.size(); ++i)
+		out[i] = portable_sin(angles[i]);
+}
+
+void PortableTrig::Cos(std::span<const float> angles, std::span<float> out)
+{
+	for (size_t i = 0; i < angles.size(); ++i)
+		out[i] = portable_cos(angles[i]);
+}
+
+void PortableTrig::SinCos(std::span<const float> angles, std::span<float> sinOut, std::span<float> cosOut)
+{
+	for (size_t i = 0; i < angles.size(); ++i)
+	{
+		sinOut[i] = portable_sin(angles[i]);
+		cosOut[i] = portable_cos(angles[i]);
+	}
+}
+
+void PortableTrig::Atan2(std::span<const float> x, std::span<const float> y, std::span<float> out)
+{
+	const size_t count = std::min(x.size(), y.size());
+	for (size_t i = 0; i < count; ++i)
+		out[i] = portable_atan2(x[i], y[i]);
+}
+
+void PortableTrig::Asin(std::span<const float> x, std::span<float> out)
+{
+	for (size_t i = 0; i < x.size(); ++i)
+		out[i] = portable_asin(x[i]);
+}
+
+void PortableTrig::Acos(std::span<const float> x, std::span<float> out)
+{
+	for (size_t i = 0; i < x.size(); ++i)
+		out[i] = portable_acos(x[i]);
+}
@@ -0,0 +1,36 @@
+#ifndef _PortableTrig_
+#define _PortableTrig_
+
+#include <ScriptUtils.h>
+
+#include <span>
+
+// Span front end for the portable_* trig exports, for code that needs
+// lockstep-safe trig on many values a turn (circular placement, steering).
+//
+// Every value comes straight from the game's portable_* functions, one
+// export call per value, so results are bit-identical to calling them
+// directly. These only save writing the loops.
+//
+// The span versions require out to be at least as long as the input.
+//
+// Main thread only, since they call the game, which WorkerPool jobs must
+// not do.
+namespace PortableTrig
+{
+	inline float Sin(float angle) { return portable_sin(angle); }
+	inline float Cos(float angle) { return portable_cos(angle); }
+	inline float Atan2(float x, float y) { return portable_atan2(x, y); }
+	inline float Asin(float x) { return portable_asin(x); }
+	inline float Acos(float x) { return portable_acos(x); }
+
+	void Sin(std::span<const float> angles, std::span<float> out);
+	void Cos(std::span<const float> angles, std::span<float> out);
+	void SinCos(std::span<const float> angles, std::span<float> sinOut, std::span<float> cosOut);
+	// Same argument order as portable_atan2
+	void Atan2(std::span<const float> x, std::span<const float> y, std::span<float> out);
+	void Asin(std::span<const float> x, std::span<float> out);
+	void Acos(std::span<const float> x, std::span<float> out);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include "Profiler.h"
+
+#ifdef MISSION_PROFILING
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+namespace
+{
+	// Log-linear buckets, HdrHistogram style: values below SUB_BUCKETS get a
+	// bucket each, above that every power of two is split into SUB_BUCKETS
+	// buckets, so every bucket is within ~6% of the values in it.
+	constexpr int SUB_BUCKET_BITS = 4;
+	constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	// Covers up to 2^36 ns, about 68 seconds. Anything longer lands in the last bucket.
+	constexpr int MAX_VALUE_BITS = 36;
+	constexpr int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	// Each callback keeps a ring of histograms, moving to the next one every
+	// WINDOW_UPDATES calls to Update, so the dump covers roughly the last
+	// WINDOW_COUNT * WINDOW_UPDATES turns instead of the whole mission.
+	constexpr int WINDOW_COUNT = 4;
+	constexpr int WINDOW_UPDATES = 1024;
+
+	struct Histogram
+	{
+		uint32_t counts[BUCKET_COUNT];
+		uint32_t total;
+		int64_t max;
+	};
+
+	struct State
+	{
+		Histogram windows[PROFILE_CALLBACK_COUNT][WINDOW_COUNT];
+		int currentWindow;
+		int updatesInWindow;
+	};
+
+	// Static so there's nothing to allocate, ~200KB
+	State s_State{};
+
+	const char* const CALLBACK_NAMES[PROFILE_CALLBACK_COUNT] = {
+		"InitialSetup",
+		"Save",
+		"Load",
+		"PostLoad",
+		"AddObject",
+		"DeleteObject",
+		"Update",
+		"PostRun",
+		"AddPlayer",
+		"DeletePlayer",
+		"PlayerEjected",
+		"ObjectKilled",
+		"ObjectSniped",
+		"GetNextRandomVehicleODF",
+		"SetWorld",
+		"ProcessCommand",
+		"SetRandomSeed",
+		"PreSnipe",
+		"PreOrdnanceHit",
+		"PreGetIn",
+		"PrePickupPowerup",
+		"PostTargetChanged",
+		"ChatMessageSent",
+	};
+
+	int BucketFor(int64_t value)
+	{
+		if (value < SUB_BUCKETS)
+			return static_cast<int>(std::max<int64_t>(value, 0));
+
+		const int msb = std::bit_width(static_cast<uint64_t>(value)) - 1;
+		if (msb >= MAX_VALUE_BITS)
+			return BUCKET_COUNT - 1;
+
+		// The top SUB_BUCKET_BITS bits below the msb pick the sub bucket
+		const int sub = static_cast<int>((value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+		return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+	}
+
+	// Highest value that lands in bucket, so percentiles err on the slow side
+	int64_t BucketUpperBound(int bucket)
+	{
+		if (bucket < SUB_BUCKETS)
+			return bucket;
+
+		const int msb = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+		const int64_t sub = bucket % SUB_BUCKETS;
+		const int shift = msb - SUB_BUCKET_BITS;
+		return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+	}
+
+	int64_t Percentile(const uint32_t* counts, uint32_t total, double percentile)
+	{
+		const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(total * percentile + 0.5));
+		uint64_t seen = 0;
+		for (int i = 0; i < BUCKET_COUNT; ++i)
+		{
+			seen += counts[i];
+			if (seen >= rank)
+				return BucketUpperBound(i);
+		}
+		return BucketUpperBound(BUCKET_COUNT - 1);
+	}
+
+	void NextWindow()
+	{
+		s_State.currentWindow = (s_State.currentWindow + 1) % WINDOW_COUNT;
+		s_State.updatesInWindow = 0;
+		for (int c = 0; c < PROFILE_CALLBACK_COUNT; ++c)
+			s_State.windows[c][s_State.currentWindow] = Histogram{};
+	}
+}
+
+void Profiler::Record(ProfileCallback callback, int64_t nanoseconds)
+{
+	Histogram& histogram = s_State.windows[callback][s_State.currentWindow];
+	++histogram.counts[BucketFor(nanoseconds)];
+	++histogram.total;
+	histogram.max = std::max(histogram.max, nanoseconds);
+
+	if (callback == PROFILE_UPDATE && ++s_State.updatesInWindow >= WINDOW_UPDATES)
+		NextWindow();
+}
+
+void Profiler::Dump()
+{
+	PrintConsoleMessage("callback: calls p50/p99/max (us)");
+
+	uint32_t merged[BUCKET_COUNT];
+	char line[128];
+	for (int c = 0; c < PROFILE_CALLBACK_COUNT; ++c)
+	{
+		std::fill(std::begin(merged), std::end(merged), 0);
+		uint32_t total = 0;
+		int64_t max = 0;
+		for (const Histogram& window : s_State.windows[c])
+		{
+			for (int i = 0; i < BUCKET_COUNT; ++i)
+				merged[i] += window.counts[i];
+			total += window.total;
+			max = std::max(max, window.max);
+		}
+
+		if (total == 0)
+			continue;
+
+		std::snprintf(line, sizeof(line), "%s: %u %.1f/%.1f/%.1f", CALLBACK_NAMES[c], total,
+			std::min(Percentile(merged, total, 0.50), max) / 1000.0,
+			std::min(Percentile(merged, total, 0.99), max) / 1000.0,
+			max / 1000.0);
+		PrintConsoleMessage(line);
+	}
+}
+
+bool Profiler::ProcessCommand(unsigned long crc)
+{
+	static const unsigned long dumpCrc = CalcCRC("dll.profile");
+	if (crc != dumpCrc)
+		return false;
+
+	Dump();
+	return true;
+}
+
+void Profiler::Reset()
+{
+	for (auto& windows : s_State.windows)
+		for (Histogram& window : windows)
+			window = Histogram{};
+	s_State.currentWindow = 0;
+	s_State.updatesInWindow = 0;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef _Profiler_
+#define _Profiler_
+
+#include <ScriptUtils.h>
+
+// Latency instrumentation for the mission's game-facing callbacks. Only
+// built when MISSION_PROFILING is defined (cmake -DMISSION_PROFILING=ON);
+// otherwise the macros at the bottom expand to the plain function or to
+// nothing, and none of this is compiled in.
+//
+// Type "dll.profile" in the console to print p50/p99/max per callback.
+
+enum ProfileCallback
+{
+	PROFILE_INITIAL_SETUP,
+	PROFILE_SAVE,
+	PROFILE_LOAD,
+	PROFILE_POST_LOAD,
+	PROFILE_ADD_OBJECT,
+	PROFILE_DELETE_OBJECT,
+	PROFILE_UPDATE,
+	PROFILE_POST_RUN,
+	PROFILE_ADD_PLAYER,
+	PROFILE_DELETE_PLAYER,
+	PROFILE_PLAYER_EJECTED,
+	PROFILE_OBJECT_KILLED,
+	PROFILE_OBJECT_SNIPED,
+	PROFILE_GET_NEXT_RANDOM_VEHICLE_ODF,
+	PROFILE_SET_WORLD,
+	PROFILE_PROCESS_COMMAND,
+	PROFILE_SET_RANDOM_SEED,
+	PROFILE_PRE_SNIPE,
+	PROFILE_PRE_ORDNANCE_HIT,
+	PROFILE_PRE_GET_IN,
+	PROFILE_PRE_PICKUP_POWERUP,
+	PROFILE_POST_TARGET_CHANGED,
+	PROFILE_CHAT_MESSAGE_SENT,
+	PROFILE_CALLBACK_COUNT,
+};
+
+#ifdef MISSION_PROFILING
+
+#include <chrono>
+#include <cstdint>
+
+namespace Profiler
+{
+	// Adds one sample. Everything is preallocated, so this never allocates.
+	void Record(ProfileCallback callback, int64_t nanoseconds);
+
+	// Prints p50/p99/max for every callback that has run recently.
+	void Dump();
+
+	// Returns true and dumps if crc is the profiler's console command.
+	bool ProcessCommand(unsigned long crc);
+
+	void Reset();
+}
+
+// Times the enclosing scope and records it under callback.
+class ProfileScope
+{
+public:
+	explicit ProfileScope(ProfileCallback callback)
+		: m_Callback(callback), m_Start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~ProfileScope()
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - m_Start;
+		Profiler::Record(m_Callback, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	ProfileCallback m_Callback;
+	std::chrono::steady_clock::time_point m_Start;
+};
+
+// Wraps an export as a function with the same signature that times each call.
+template <ProfileCallback Callback, auto Fn>
+struct ProfiledExport;
+
+template <ProfileCallback Callback, typename R, typename... Args, R (DLLAPI* Fn)(Args...)>
+struct ProfiledExport<Callback, Fn>
+{
+	static R DLLAPI Call(Args... args)
+	{
+		ProfileScope scope(Callback);
+		return Fn(args...);
+	}
+};
+
+#define PROFILE_SCOPE(callback) ProfileScope profileScope_(callback)
+#define PROFILED_EXPORT(callback, fn) (&ProfiledExport<callback, &fn>::Call)
+
+#else
+
+#define PROFILE_SCOPE(callback)
+#define PROFILED_EXPORT(callback, fn) (fn)
+
+#endif
+
+#endif
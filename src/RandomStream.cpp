@@ -0,0 +1,129 @@
+#include "RandomStream.h"
+
+namespace
+{
+	constexpr uint32_t RANDOM_SAVE_TAG = 'RAND';
+	constexpr uint32_t RANDOM_SAVE_VERSION = 1;
+
+	uint64_t SplitMix64(uint64_t& x)
+	{
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	struct SavedStream
+	{
+		uint32_t id;
+		uint32_t state[4];
+	};
+}
+
+void RandomStream::Seed(uint64_t seed)
+{
+	const uint64_t a = SplitMix64(seed);
+	const uint64_t b = SplitMix64(seed);
+	m_State[0] = static_cast<uint32_t>(a);
+	m_State[1] = static_cast<uint32_t>(a >> 32);
+	m_State[2] = static_cast<uint32_t>(b);
+	m_State[3] = static_cast<uint32_t>(b >> 32);
+	if ((m_State[0] | m_State[1] | m_State[2] | m_State[3]) == 0)
+		m_State[0] = 1;
+}
+
+void RandomStream::Mix(uint64_t seed)
+{
+	const uint64_t a = SplitMix64(seed);
+	const uint64_t b = SplitMix64(seed);
+	m_State[0] ^= static_cast<uint32_t>(a);
+	m_State[1] ^= static_cast<uint32_t>(a >> 32);
+	m_State[2] ^= static_cast<uint32_t>(b);
+	m_State[3] ^= static_cast<uint32_t>(b >> 32);
+	if ((m_State[0] | m_State[1] | m_State[2] | m_State[3]) == 0)
+		m_State[0] = 1;
+}
+
+void RandomStream::Fill(std::span<float> out, float range)
+{
+	for (float& v : out)
+		v = Float(range);
+}
+
+void RandomStream::Fill(std::span<float> out, float min, float max)
+{
+	for (float& v : out)
+		v = Float(min, max);
+}
+
+void RandomStream::Fill(std::span<int> out, int min, int max)
+{
+	for (int& v : out)
+		v = Int(min, max);
+}
+
+void RandomStream::GetState(uint32_t state[4]) const
+{
+	for (int i = 0; i < 4; ++i)
+		state[i] = m_State[i];
+}
+
+bool RandomStream::SetState(const uint32_t state[4])
+{
+	if ((state[0] | state[1] | state[2] | state[3]) == 0)
+		return false;
+	for (int i = 0; i < 4; ++i)
+		m_State[i] = state[i];
+	return true;
+}
+
+RandomStream& RandomStreams::Get(uint32_t id)
+{
+	// Streams start out different even before the first SetSeed
+	auto it = m_Streams.find(id);
+	if (it == m_Streams.end())
+		it = m_Streams.emplace(id, RandomStream(id)).first;
+	return it->second;
+}
+
+void RandomStreams::SetSeed(unsigned long seed)
+{
+	// The id goes in too so streams don't all get the same mix
+	for (auto& [id, stream] : m_Streams)
+		stream.Mix((static_cast<uint64_t>(id) << 32) ^ seed);
+}
+
+void RandomStreams::Save(SaveWriter& writer) const
+{
+	writer.BeginSection(RANDOM_SAVE_TAG, RANDOM_SAVE_VERSION);
+	writer.Write(static_cast<uint32_t>(m_Streams.size()));
+	for (const auto& [id, stream] : m_Streams)
+	{
+		SavedStream saved{};
+		saved.id = id;
+		stream.GetState(saved.state);
+		writer.Write(saved);
+	}
+	writer.EndSection();
+}
+
+bool RandomStreams::Load(SaveReader& reader)
+{
+	// Saves from before this carry on from wherever the streams are now
+	uint32_t version = 0;
+	if (!reader.OpenSection(RANDOM_SAVE_TAG, version))
+		return true;
+	if (version != RANDOM_SAVE_VERSION)
+		return false;
+
+	uint32_t count = 0;
+	if (!reader.Read(count))
+		return false;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		SavedStream saved{};
+		if (!reader.Read(saved) || !Get(saved.id).SetState(saved.state))
+			return false;
+	}
+	return true;
+}
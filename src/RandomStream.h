@@ -0,0 +1,106 @@
+#ifndef _RandomStream_
+#define _RandomStream_
+
+#include "SaveBuffer.h"
+
+#include <cstdint>
+#include <map>
+#include <span>
+
+// xoshiro128** generator. Same sequence on every machine for the same
+// seed, so anything drawn from it in lockstep code stays in sync as long
+// as every machine draws the same amount, and it's a few instructions
+// per number instead of a GetRandomFloat export call.
+class RandomStream
+{
+public:
+	RandomStream() { Seed(0); }
+	explicit RandomStream(uint64_t seed) { Seed(seed); }
+
+	void Seed(uint64_t seed);
+
+	// Folds seed into the current state instead of replacing it.
+	void Mix(uint64_t seed);
+
+	uint32_t Next()
+	{
+		const uint32_t result = Rotl(m_State[1] * 5, 7) * 9;
+		const uint32_t t = m_State[1] << 9;
+		m_State[2] ^= m_State[0];
+		m_State[3] ^= m_State[1];
+		m_State[1] ^= m_State[2];
+		m_State[0] ^= m_State[3];
+		m_State[2] ^= t;
+		m_State[3] = Rotl(m_State[3], 11);
+		return result;
+	}
+
+	// [0, 1)
+	float NextFloat() { return static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f); }
+
+	// [0, range), like GetRandomFloat
+	float Float(float range) { return NextFloat() * range; }
+
+	// [min, max)
+	float Float(float min, float max) { return min + NextFloat() * (max - min); }
+
+	// [min, max], both ends included
+	int Int(int min, int max)
+	{
+		const uint32_t span = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1;
+		if (span == 0)
+			return static_cast<int>(Next());
+		return static_cast<int>(static_cast<uint32_t>(min) + static_cast<uint32_t>((static_cast<uint64_t>(Next()) * span) >> 32));
+	}
+
+	bool Chance(float probability) { return NextFloat() < probability; }
+
+	// Fill out with the same values the single calls would give, in order
+	void Fill(std::span<float> out, float range);
+	void Fill(std::span<float> out, float min, float max);
+	void Fill(std::span<int> out, int min, int max);
+
+	// For saving; SetState rejects the all-zero state xoshiro can't leave.
+	void GetState(uint32_t state[4]) const;
+	bool SetState(const uint32_t state[4]);
+
+private:
+	static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+	uint32_t m_State[4];
+};
+
+// Independent RandomStreams per subsystem, keyed by four character codes
+// like the save sections. Each stream only advances when its own module
+// draws from it, so adding a random call to the spawner never changes
+// what the AI or loot rolls get.
+//
+// SetSeed runs on every stream from the mission's SetRandomSeed, which the
+// game calls at the top of each frame with the same value on every
+// machine. Streams keep their state between frames and across Save/Load.
+//
+// Grab a stream once and keep the reference, it stays valid:
+//
+//   RandomStream& lootRandom = randomStreams.Get(RANDOM_LOOT);
+class RandomStreams
+{
+public:
+	RandomStream& Get(uint32_t id);
+
+	// Mixes the game's per-frame seed into every stream.
+	void SetSeed(unsigned long seed);
+
+	// Saved as the 'RAND' section. Call from the mission's Save/Load.
+	void Save(SaveWriter& writer) const;
+	bool Load(SaveReader& reader);
+
+private:
+	// Ordered so saving and seeding go through the streams the same way everywhere
+	std::map<uint32_t, RandomStream> m_Streams;
+};
+
+constexpr uint32_t RANDOM_SPAWNER = 'SPWN';
+constexpr uint32_t RANDOM_AI = 'AI  ';
+constexpr uint32_t RANDOM_LOOT = 'LOOT';
+
+#endif
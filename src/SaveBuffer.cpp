@@ -0,0 +1,169 @@
+#include "SaveBuffer.h"
+
+#include <climits>
+
+namespace
+{
+	// Bump this if the section framing itself changes. Per-module layout
+	// changes go in the section version instead.
+	constexpr int SAVE_FORMAT_VERSION = 1;
+
+	// tag, version, byte length
+	constexpr size_t SECTION_HEADER_SIZE = sizeof(uint32_t) * 3;
+}
+
+void SaveWriter::BeginSection(uint32_t tag, uint32_t version)
+{
+	if (m_InSection)
+		EndSection();
+
+	m_SectionStart = m_Buffer.size();
+	m_InSection = true;
+
+	const uint32_t header[3] = { tag, version, 0 };
+	WriteBytes(header, sizeof(header));
+}
+
+void SaveWriter::EndSection()
+{
+	if (!m_InSection)
+		return;
+
+	// Patch the length in now that we know it
+	const uint32_t length = static_cast<uint32_t>(m_Buffer.size() - m_SectionStart - SECTION_HEADER_SIZE);
+	std::memcpy(m_Buffer.data() + m_SectionStart + sizeof(uint32_t) * 2, &length, sizeof(length));
+	m_InSection = false;
+}
+
+bool SaveWriter::Flush()
+{
+	EndSection();
+
+	if (m_Buffer.size() > static_cast<size_t>(INT_MAX))
+		return false;
+
+	int header[2] = { SAVE_FORMAT_VERSION, static_cast<int>(m_Buffer.size()) };
+	bool ret = ::Write(header, 2);
+	if (!m_Buffer.empty())
+		ret = ret && ::Write(static_cast<void*>(m_Buffer.data()), header[1]);
+	return ret;
+}
+
+void SaveWriter::Clear()
+{
+	m_Buffer.clear();
+	m_SectionStart = 0;
+	m_InSection = false;
+}
+
+bool SaveReader::Load()
+{
+	Clear();
+
+	int header[2] = {};
+	if (!::Read(header, 2) || header[0] != SAVE_FORMAT_VERSION || header[1] < 0)
+		return false;
+
+	m_Buffer.resize(header[1]);
+	if (header[1] > 0 && !::Read(static_cast<void*>(m_Buffer.data()), header[1]))
+		return false;
+
+	// Index the sections so modules can open them in any order
+	size_t offset = 0;
+	while (offset + SECTION_HEADER_SIZE <= m_Buffer.size())
+	{
+		uint32_t sectionHeader[3];
+		std::memcpy(sectionHeader, m_Buffer.data() + offset, SECTION_HEADER_SIZE);
+		const size_t start = offset + SECTION_HEADER_SIZE;
+		if (sectionHeader[2] > m_Buffer.size() - start)
+			return false;
+
+		m_Sections.push_back({ sectionHeader[0], sectionHeader[1], start, start + sectionHeader[2] });
+		offset = start + sectionHeader[2];
+	}
+	return offset == m_Buffer.size();
+}
+
+bool SaveReader::OpenSection(uint32_t tag, uint32_t& version)
+{
+	for (const Section& section : m_Sections)
+	{
+		if (section.tag == tag)
+		{
+			version = section.version;
+			m_Cursor = section.start;
+			m_SectionEnd = section.end;
+			return true;
+		}
+	}
+
+	m_Cursor = 0;
+	m_SectionEnd = 0;
+	return false;
+}
+
+bool SaveReader::ReadString(std::string& str)
+{
+	uint32_t length = 0;
+	if (!Read(length) || length > m_SectionEnd - m_Cursor)
+		return false;
+
+	str.assign(reinterpret_cast<const char*>(m_Buffer.data() + m_Cursor), length);
+	m_Cursor += length;
+	return true;
+}
+
+bool SaveReader::ReadHandle(Handle& h)
+{
+	Handle saved = 0;
+	if (!Read(saved))
+		return false;
+
+	h = saved;
+	m_Fixups.push_back({ &h, nullptr, 0 });
+	m_SavedHandles.push_back(saved);
+	return true;
+}
+
+bool SaveReader::ReadHandles(std::vector<Handle>& handles)
+{
+	if (!ReadArray(handles))
+		return false;
+
+	for (size_t i = 0; i < handles.size(); ++i)
+	{
+		m_Fixups.push_back({ nullptr, &handles, i });
+		m_SavedHandles.push_back(handles[i]);
+	}
+	return true;
+}
+
+void SaveReader::ConvertHandles()
+{
+	if (m_SavedHandles.empty())
+		return;
+
+	::ConvertHandles(m_SavedHandles.data(), static_cast<int>(m_SavedHandles.size()));
+
+	for (size_t i = 0; i < m_Fixups.size(); ++i)
+	{
+		const HandleFixup& fixup = m_Fixups[i];
+		if (fixup.single)
+			*fixup.single = m_SavedHandles[i];
+		else if (fixup.index < fixup.array->size())
+			(*fixup.array)[fixup.index] = m_SavedHandles[i];
+	}
+
+	m_Fixups.clear();
+	m_SavedHandles.clear();
+}
+
+void SaveReader::Clear()
+{
+	m_Buffer.clear();
+	m_Sections.clear();
+	m_Cursor = 0;
+	m_SectionEnd = 0;
+	m_Fixups.clear();
+	m_SavedHandles.clear();
+}
@@ -0,0 +1,165 @@
+#ifndef _SaveBuffer_
+#define _SaveBuffer_
+
+#include <ScriptUtils.h>
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Mission save data is laid out as a list of tagged, versioned sections:
+//
+//   [tag][version][byte length][payload...] [tag][version][byte length]...
+//
+// Tags are four character codes in the same style as
+// LATEST_DLL_VERSION_MODIFIER, e.g. 'TIMR'. A reader can look up sections
+// in any order and skip ones it doesn't know, and each module checks its
+// own version to stay compatible with older saves.
+
+// Accumulates every module's save data into one contiguous buffer, then
+// hands the whole thing to the game with a single Write() call (plus one
+// for the size) instead of one export call per field.
+class SaveWriter
+{
+public:
+	// Starts a section. Everything written up to EndSection() belongs to it.
+	void BeginSection(uint32_t tag, uint32_t version);
+	void EndSection();
+
+	void WriteBytes(const void* data, size_t size)
+	{
+		const size_t offset = m_Buffer.size();
+		m_Buffer.resize(offset + size);
+		if (size > 0)
+			std::memcpy(m_Buffer.data() + offset, data, size);
+	}
+
+	template <typename T>
+		requires std::is_trivially_copyable_v<T>
+	void Write(const T& value)
+	{
+		WriteBytes(&value, sizeof(T));
+	}
+
+	// Writes a count followed by the elements.
+	template <typename T>
+		requires std::is_trivially_copyable_v<T>
+	void WriteArray(std::span<const T> values)
+	{
+		Write(static_cast<uint32_t>(values.size()));
+		WriteBytes(values.data(), values.size_bytes());
+	}
+
+	void WriteString(std::string_view str)
+	{
+		Write(static_cast<uint32_t>(str.size()));
+		WriteBytes(str.data(), str.size());
+	}
+
+	// Handles are written as-is; SaveReader remaps them after the load.
+	void WriteHandle(Handle h) { Write(h); }
+	void WriteHandles(std::span<const Handle> handles) { WriteArray(handles); }
+
+	// Sends the buffer to the game. Call once, at the end of Save.
+	bool Flush();
+
+	void Clear();
+
+	size_t Size() const { return m_Buffer.size(); }
+
+private:
+	std::vector<uint8_t> m_Buffer;
+	size_t m_SectionStart = 0;
+	bool m_InSection = false;
+};
+
+// Reads back what SaveWriter wrote: one Read() for the size, one for the
+// whole buffer. Handles read through ReadHandle(s) are collected and
+// remapped with a single ConvertHandles() call from PostLoad, so the
+// variables they were read into must stay put until then.
+//
+// All Read* calls return false (and leave the output alone) past the end
+// of the open section, so a truncated or older save fails cleanly.
+class SaveReader
+{
+public:
+	// Pulls the buffer in from the game. Call once, at the start of Load.
+	bool Load();
+
+	// Positions the reader at the start of the section with this tag.
+	// Returns false if the save doesn't have it.
+	bool OpenSection(uint32_t tag, uint32_t& version);
+
+	bool ReadBytes(void* data, size_t size)
+	{
+		if (m_Cursor + size > m_SectionEnd)
+			return false;
+		if (size > 0)
+			std::memcpy(data, m_Buffer.data() + m_Cursor, size);
+		m_Cursor += size;
+		return true;
+	}
+
+	template <typename T>
+		requires std::is_trivially_copyable_v<T>
+	bool Read(T& value)
+	{
+		return ReadBytes(&value, sizeof(T));
+	}
+
+	// Reads a count and then that many elements, replacing values.
+	template <typename T>
+		requires std::is_trivially_copyable_v<T>
+	bool ReadArray(std::vector<T>& values)
+	{
+		uint32_t count = 0;
+		if (!Read(count) || static_cast<size_t>(count) * sizeof(T) > m_SectionEnd - m_Cursor)
+			return false;
+		values.resize(count);
+		return ReadBytes(values.data(), values.size() * sizeof(T));
+	}
+
+	bool ReadString(std::string& str);
+
+	// Reads a handle and queues it to be remapped by ConvertHandles().
+	bool ReadHandle(Handle& h);
+	bool ReadHandles(std::vector<Handle>& handles);
+
+	// Remaps every handle read since Load() with one ConvertHandles
+	// export call, writing the new values back. Call from PostLoad.
+	void ConvertHandles();
+
+	void Clear();
+
+private:
+	struct Section
+	{
+		uint32_t tag;
+		uint32_t version;
+		size_t start;
+		size_t end;
+	};
+
+	std::vector<uint8_t> m_Buffer;
+	std::vector<Section> m_Sections;
+	size_t m_Cursor = 0;
+	size_t m_SectionEnd = 0;
+
+	// Where each handle read from the save lives, and its saved value.
+	// Array handles are stored as (vector, index) since the vector's
+	// storage is allowed to move as long as the vector itself doesn't.
+	struct HandleFixup
+	{
+		Handle* single;
+		std::vector<Handle>* array;
+		size_t index;
+	};
+	std::vector<HandleFixup> m_Fixups;
+	std::vector<Handle> m_SavedHandles;
+};
+
+#endif
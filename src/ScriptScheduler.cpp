@@ -0,0 +1,113 @@
+#include "ScriptScheduler.h"
+
+#include <algorithm>
+
+void ScriptScheduler::Start(ScriptTask task)
+{
+	task.Resume();
+	if (!task.IsDone())
+		m_Tasks.push_back(std::move(task));
+}
+
+void ScriptScheduler::Update(long turn)
+{
+	m_CurrentTurn = turn;
+
+	// Pull everything due first, since resumed tasks push new waits onto the heap
+	m_Waking.clear();
+	while (!m_TurnWaits.empty() && m_TurnWaits.front().due <= turn)
+	{
+		std::pop_heap(m_TurnWaits.begin(), m_TurnWaits.end());
+		m_Waking.push_back(m_TurnWaits.back().handle);
+		m_TurnWaits.pop_back();
+	}
+
+	// Keep the remaining polls in order so they're checked the same way everywhere
+	size_t kept = 0;
+	for (size_t i = 0; i < m_Polls.size(); ++i)
+	{
+		if (Poll(*m_Polls[i].awaiter))
+			m_Waking.push_back(m_Polls[i].handle);
+		else
+			m_Polls[kept++] = m_Polls[i];
+	}
+	m_Polls.resize(kept);
+
+	// Whatever these wait on next counts from turn, even without BeginTurn
+	const bool inTurn = m_InTurn;
+	m_InTurn = true;
+	for (size_t i = 0; i < m_Waking.size(); ++i)
+		m_Waking[i].resume();
+	m_InTurn = inTurn;
+
+	ReapFinished();
+}
+
+void ScriptScheduler::NotifyDestroyed(Handle h)
+{
+	// Pulled out first so tasks waiting on the same handle again don't get
+	// woken twice. A woken task can remove objects and land back in here,
+	// so each call only uses the scratch past where its caller's wakes end.
+	const size_t first = m_DeathWaking.size();
+	size_t kept = 0;
+	for (size_t i = 0; i < m_DeathWaits.size(); ++i)
+	{
+		if (m_DeathWaits[i].h == h)
+			m_DeathWaking.push_back(m_DeathWaits[i].handle);
+		else
+			m_DeathWaits[kept++] = m_DeathWaits[i];
+	}
+	m_DeathWaits.resize(kept);
+
+	const size_t last = m_DeathWaking.size();
+	if (first == last)
+		return;
+
+	for (size_t i = first; i < last; ++i)
+		m_DeathWaking[i].resume();
+	m_DeathWaking.resize(first);
+
+	ReapFinished();
+}
+
+void ScriptScheduler::Clear()
+{
+	// Drop every reference to a suspended frame before destroying the frames
+	m_TurnWaits.clear();
+	m_DeathWaits.clear();
+	m_Polls.clear();
+	m_Waking.clear();
+	m_DeathWaking.clear();
+	m_Tasks.clear();
+}
+
+void ScriptScheduler::AddTurnWait(long turns, std::coroutine_handle<> h)
+{
+	// Outside Update the last turn we saw is stale, the game may be a turn on
+	const long now = m_InTurn ? m_CurrentTurn : GetLockstepTurn();
+	m_TurnWaits.push_back({ now + turns, m_NextSeq++, h });
+	std::push_heap(m_TurnWaits.begin(), m_TurnWaits.end());
+}
+
+bool ScriptScheduler::Poll(PollAwaiter& awaiter)
+{
+	switch (awaiter.type)
+	{
+	case POLL_AUDIO:
+		return IsAudioMessageDone(awaiter.audioMsg);
+
+	case POLL_CAMERA_PATH:
+		if (CameraCancelled())
+		{
+			awaiter.cancelled = true;
+			return true;
+		}
+		return CameraPath(awaiter.path, awaiter.height, awaiter.speed, awaiter.target);
+	}
+	return true;
+}
+
+void ScriptScheduler::ReapFinished()
+{
+	std::erase_if(m_Tasks, [](const ScriptTask& task) { return task.IsDone(); });
+}
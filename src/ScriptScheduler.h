@@ -0,0 +1,185 @@
+#ifndef _ScriptScheduler_
+#define _ScriptScheduler_
+
+#include <ScriptUtils.h>
+
+#include "ScriptTask.h"
+
+#include <coroutine>
+#include <cstdint>
+#include <vector>
+
+// Runs ScriptTasks and owns everything they can wait on. Waiting tasks sit
+// in a queue for the thing they're waiting for, so Update() only resumes
+// tasks whose condition actually came true:
+//
+// - Turn waits are kept in a heap ordered by due turn.
+// - Death waits are kept in a flat list and woken from DeleteObject/ObjectKilled.
+// - Audio and camera waits have no game callback, so those (and only those)
+//   are polled once per Update.
+//
+// Wake order is fixed so sequences run identically on every client. An
+// Update resumes its due turn waits first, earliest due turn first and in
+// the order they started waiting within a turn, then its finished polls in
+// the order they started waiting. Death waits on the same handle resume in
+// the order they started waiting.
+class ScriptScheduler
+{
+public:
+	ScriptScheduler() = default;
+	ScriptScheduler(const ScriptScheduler&) = delete;
+	ScriptScheduler& operator=(const ScriptScheduler&) = delete;
+	~ScriptScheduler() { Clear(); }
+
+	// Takes ownership of task and runs it up to its first wait.
+	void Start(ScriptTask task);
+
+	// Turn waits count from the turn set here. Call at the top of Update,
+	// before anything can start a task, and EndTurn at the bottom. Waits
+	// started outside that, like from DeleteObject, ask the game instead.
+	void BeginTurn(long turn)
+	{
+		m_CurrentTurn = turn;
+		m_InTurn = true;
+	}
+
+	void EndTurn() { m_InTurn = false; }
+
+	// Resumes everything whose wait is over as of turn. Call once per Update
+	// with the turn passed to BeginTurn.
+	void Update(long turn);
+
+	// Wakes tasks waiting for h to die. Call from DeleteObject and
+	// ObjectKilled.
+	void NotifyDestroyed(Handle h);
+
+	// Destroys every task, running or waiting.
+	void Clear();
+
+	size_t GetTaskCount() const { return m_Tasks.size(); }
+
+	struct TurnAwaiter
+	{
+		ScriptScheduler& scheduler;
+		long turns;
+
+		bool await_ready() const noexcept { return turns <= 0; }
+		void await_suspend(std::coroutine_handle<> h) { scheduler.AddTurnWait(turns, h); }
+		void await_resume() const noexcept {}
+	};
+
+	struct DeathAwaiter
+	{
+		ScriptScheduler& scheduler;
+		Handle h;
+
+		bool await_ready() const { return h == 0 || !IsAround(h); }
+		void await_suspend(std::coroutine_handle<> awaiting) { scheduler.m_DeathWaits.push_back({ h, awaiting }); }
+		void await_resume() const noexcept {}
+	};
+
+	enum PollType
+	{
+		POLL_AUDIO,
+		POLL_CAMERA_PATH,
+	};
+
+	struct PollAwaiter
+	{
+		ScriptScheduler& scheduler;
+		PollType type;
+		int audioMsg = 0;
+		ConstName path = nullptr;
+		int height = 0;
+		int speed = 0;
+		Handle target = 0;
+		bool cancelled = false;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> h) { scheduler.m_Polls.push_back({ h, this }); }
+		// For camera waits, true if the path finished and false if the
+		// player cancelled it. Always true for audio waits.
+		bool await_resume() const noexcept { return !cancelled; }
+	};
+
+	// co_await WaitTurns(n) resumes exactly n lockstep turns later.
+	TurnAwaiter WaitTurns(long turns) { return { *this, turns }; }
+	TurnAwaiter WaitSeconds(float seconds) { return { *this, SecondsToTurns(seconds) }; }
+
+	// Resumes once IsAudioMessageDone(msg) is true.
+	PollAwaiter WaitAudio(int msg)
+	{
+		PollAwaiter a{ *this, POLL_AUDIO };
+		a.audioMsg = msg;
+		return a;
+	}
+
+	// Drives CameraPath(path, height, speed, target) every turn and resumes
+	// when it finishes or the player cancels. Call CameraReady() first and
+	// CameraFinish() after, as usual. path must outlive the wait.
+	PollAwaiter WaitCameraPath(ConstName path, int height, int speed, Handle target)
+	{
+		PollAwaiter a{ *this, POLL_CAMERA_PATH };
+		a.path = path;
+		a.height = height;
+		a.speed = speed;
+		a.target = target;
+		return a;
+	}
+
+	// Resumes when h is killed or removed. Doesn't suspend at all if h is
+	// already gone.
+	DeathAwaiter WaitForDeath(Handle h) { return { *this, h }; }
+
+private:
+	struct TurnWait
+	{
+		long due;
+		uint32_t seq;
+		std::coroutine_handle<> handle;
+
+		// Inverted so std::push_heap/pop_heap give the earliest wait first
+		bool operator<(const TurnWait& other) const
+		{
+			return due != other.due ? due > other.due : seq > other.seq;
+		}
+	};
+
+	struct DeathWait
+	{
+		Handle h;
+		std::coroutine_handle<> handle;
+	};
+
+	struct PollWait
+	{
+		std::coroutine_handle<> handle;
+		PollAwaiter* awaiter;
+	};
+
+	void AddTurnWait(long turns, std::coroutine_handle<> h);
+
+	// Returns true if the poll's condition is met.
+	static bool Poll(PollAwaiter& awaiter);
+
+	// Destroys tasks that ran to completion.
+	void ReapFinished();
+
+	std::vector<ScriptTask> m_Tasks;
+
+	std::vector<TurnWait> m_TurnWaits;
+	// Only a few tasks wait on deaths at once, so a scan beats a map, and
+	// keeping the capacity means waiting doesn't allocate
+	std::vector<DeathWait> m_DeathWaits;
+	std::vector<PollWait> m_Polls;
+
+	long m_CurrentTurn = -1;
+	bool m_InTurn = false;
+	uint32_t m_NextSeq = 0;
+
+	// Scratch, kept around so waking tasks doesn't allocate
+	std::vector<std::coroutine_handle<>> m_Waking;
+	std::vector<std::coroutine_handle<>> m_DeathWaking;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "ScriptTask.h"
+
+#include <new>
+
+namespace
+{
+	// Bucket sizes are MIN_BLOCK << n, up to MIN_BLOCK << (BUCKET_COUNT - 1)
+	constexpr size_t MIN_BLOCK = 64;
+	constexpr size_t BUCKET_COUNT = 6;
+	constexpr size_t BLOCKS_PER_CHUNK = 16;
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct Pool
+	{
+		FreeBlock* freeLists[BUCKET_COUNT] = {};
+	};
+
+	Pool& GetPool()
+	{
+		// Deliberately never destroyed: global schedulers free their frames
+		// during static destruction, which may run after this would have.
+		static Pool* pool = new Pool;
+		return *pool;
+	}
+
+	// Returns the bucket a frame of size bytes lives in, or BUCKET_COUNT if
+	// it's too big for the pool.
+	size_t BucketFor(size_t size)
+	{
+		size_t bucket = 0;
+		size_t blockSize = MIN_BLOCK;
+		while (bucket < BUCKET_COUNT && blockSize < size)
+		{
+			blockSize <<= 1;
+			++bucket;
+		}
+		return bucket;
+	}
+}
+
+void* CoroutineFramePool::Allocate(size_t size)
+{
+	const size_t bucket = BucketFor(size);
+	if (bucket >= BUCKET_COUNT)
+		return ::operator new(size);
+
+	Pool& pool = GetPool();
+	if (!pool.freeLists[bucket])
+	{
+		// Carve a new chunk into blocks for this bucket
+		const size_t blockSize = MIN_BLOCK << bucket;
+		char* chunk = static_cast<char*>(::operator new(blockSize * BLOCKS_PER_CHUNK));
+		for (size_t i = 0; i < BLOCKS_PER_CHUNK; ++i)
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+			block->next = pool.freeLists[bucket];
+			pool.freeLists[bucket] = block;
+		}
+	}
+
+	FreeBlock* block = pool.freeLists[bucket];
+	pool.freeLists[bucket] = block->next;
+	return block;
+}
+
+void CoroutineFramePool::Free(void* p, size_t size)
+{
+	if (!p)
+		return;
+
+	const size_t bucket = BucketFor(size);
+	if (bucket >= BUCKET_COUNT)
+	{
+		::operator delete(p);
+		return;
+	}
+
+	Pool& pool = GetPool();
+	FreeBlock* block = static_cast<FreeBlock*>(p);
+	block->next = pool.freeLists[bucket];
+	pool.freeLists[bucket] = block;
+}
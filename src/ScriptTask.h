@@ -0,0 +1,117 @@
+#ifndef _ScriptTask_
+#define _ScriptTask_
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+// Free-list pool for coroutine frames, bucketed by size. Frames are
+// recycled instead of returned to the heap, so once a mission's scripts
+// have all run once, starting and finishing tasks allocates nothing.
+// Frames bigger than the largest bucket fall through to operator new.
+// Main thread only.
+namespace CoroutineFramePool
+{
+	void* Allocate(size_t size);
+	void Free(void* p, size_t size);
+}
+
+// Coroutine type for scripted mission sequences. Write a sequence as a
+// function returning ScriptTask and co_await the ScriptScheduler's wait
+// functions instead of building a state machine polled from Update:
+//
+// ScriptTask IntroSequence(ScriptScheduler& s)
+// {
+//     co_await s.WaitAudio(AudioMessage("intro01.wav"));
+//     co_await s.WaitSeconds(2.0f);
+//     co_await s.WaitForDeath(GetHandle("boss"));
+//     SucceedMission(GetTime() + 5.0f, "win.des");
+// }
+//
+// scheduler.Start(IntroSequence(scheduler));
+//
+// A ScriptTask can also co_await another ScriptTask to run it as a sub
+// sequence. Tasks start suspended and do nothing until started or
+// awaited. Coroutine state can't be written to a save file, so restart
+// sequences from PostLoad as needed.
+class ScriptTask
+{
+public:
+	struct promise_type;
+	using handle_type = std::coroutine_handle<promise_type>;
+
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept { return false; }
+
+		// Hand control straight back to whoever awaited this task, if anyone
+		std::coroutine_handle<> await_suspend(handle_type h) noexcept
+		{
+			const std::coroutine_handle<> continuation = h.promise().continuation;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	struct promise_type
+	{
+		std::coroutine_handle<> continuation;
+
+		ScriptTask get_return_object() { return ScriptTask(handle_type::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		FinalAwaiter final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+
+		static void* operator new(size_t size) { return CoroutineFramePool::Allocate(size); }
+		static void operator delete(void* p, size_t size) { CoroutineFramePool::Free(p, size); }
+	};
+
+	ScriptTask() = default;
+	explicit ScriptTask(handle_type h) : m_Handle(h) {}
+	ScriptTask(ScriptTask&& other) noexcept : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+	ScriptTask& operator=(ScriptTask&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (m_Handle)
+				m_Handle.destroy();
+			m_Handle = std::exchange(other.m_Handle, nullptr);
+		}
+		return *this;
+	}
+	ScriptTask(const ScriptTask&) = delete;
+	ScriptTask& operator=(const ScriptTask&) = delete;
+
+	~ScriptTask()
+	{
+		if (m_Handle)
+			m_Handle.destroy();
+	}
+
+	bool IsValid() const { return static_cast<bool>(m_Handle); }
+	bool IsDone() const { return !m_Handle || m_Handle.done(); }
+
+	// Runs the task until its first suspension point.
+	void Resume()
+	{
+		if (m_Handle && !m_Handle.done())
+			m_Handle.resume();
+	}
+
+	// Awaiting a task runs it as a sub sequence of the awaiting task
+	bool await_ready() const noexcept { return IsDone(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		m_Handle.promise().continuation = awaiting;
+		return m_Handle;
+	}
+	void await_resume() const noexcept {}
+
+private:
+	handle_type m_Handle;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "SpatialGrid.h"
+
+#include "EntityTable.h"
+
+#include <cmath>
+
+void SpatialGrid::Init(float minX, float minZ, float maxX, float maxZ, float cellSize)
+{
+	// Keep the cell count sane even if the bounds or cell size are garbage
+	constexpr int MAX_CELLS_PER_AXIS = 1024;
+
+	m_MinX = minX;
+	m_MinZ = minZ;
+	m_CellSize = cellSize > 1.0f ? cellSize : 1.0f;
+	m_InvCellSize = 1.0f / m_CellSize;
+	m_CellsX = std::clamp(static_cast<int>(std::ceil((maxX - minX) * m_InvCellSize)), 1, MAX_CELLS_PER_AXIS);
+	m_CellsZ = std::clamp(static_cast<int>(std::ceil((maxZ - minZ) * m_InvCellSize)), 1, MAX_CELLS_PER_AXIS);
+
+	m_CellStart.assign(static_cast<size_t>(m_CellsX) * m_CellsZ + 1, 0);
+	m_SortedIndex.clear();
+	m_SortedX.clear();
+	m_SortedZ.clear();
+}
+
+void SpatialGrid::InitFromTerrain(float cellSize)
+{
+	Init(GetTerrainMinX(), GetTerrainMinZ(), GetTerrainMaxX(), GetTerrainMaxZ(), cellSize);
+}
+
+void SpatialGrid::Build(const EntityTable& table)
+{
+	if (!IsInitialized())
+		InitFromTerrain();
+
+	const auto positions = table.GetPositions();
+	const size_t count = positions.size();
+
+	m_EntityCell.resize(count);
+	m_SortedIndex.resize(count);
+	m_SortedX.resize(count);
+	m_SortedZ.resize(count);
+
+	// Counting sort: histogram, exclusive prefix sum, then scatter
+	std::fill(m_CellStart.begin(), m_CellStart.end(), 0);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t cell = CellZ(positions[i].z) * m_CellsX + CellX(positions[i].x);
+		m_EntityCell[i] = cell;
+		++m_CellStart[cell + 1];
+	}
+	for (size_t c = 1; c < m_CellStart.size(); ++c)
+		m_CellStart[c] += m_CellStart[c - 1];
+
+	// m_CellStart[c] doubles as the write cursor for cell c while
+	// scattering, leaving it at the cell's end; shifting it up one slot
+	// afterwards restores the start offsets
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t s = m_CellStart[m_EntityCell[i]]++;
+		m_SortedIndex[s] = static_cast<uint32_t>(i);
+		m_SortedX[s] = positions[i].x;
+		m_SortedZ[s] = positions[i].z;
+	}
+	for (size_t c = m_CellStart.size() - 1; c > 0; --c)
+		m_CellStart[c] = m_CellStart[c - 1];
+	m_CellStart[0] = 0;
+}
+
+size_t SpatialGrid::QueryRadius(const Vector& center, float radius, std::vector<uint32_t>& out) const
+{
+	const size_t before = out.size();
+	ForEachInRadius(center, radius, [&](uint32_t i, float) { out.push_back(i); });
+	return out.size() - before;
+}
@@ -0,0 +1,285 @@
+#ifndef _SpatialGrid_
+#define _SpatialGrid_
+
+#include <ScriptUtils.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class EntityTable;
+
+// Uniform spatial hash over the XZ plane, covering the terrain bounds.
+// Rebuilt from the EntityTable snapshot each Update (counting sort, O(n)),
+// then answers proximity queries by only visiting nearby cells instead of
+// scanning every object like GetNearestEnemy/CountUnitsNearObject do.
+//
+// All queries return indices into the EntityTable the grid was built
+// from, and are only valid until that table changes. Distances are 2D
+// (XZ), same as the game's own proximity functions.
+class SpatialGrid
+{
+public:
+	static constexpr float DEFAULT_CELL_SIZE = 64.0f;
+
+	// (distSq, index), FindKNearest's working heap
+	using Neighbor = std::pair<float, uint32_t>;
+
+	// Lays out the cells over the given XZ bounds. Clears any built data.
+	void Init(float minX, float minZ, float maxX, float maxZ, float cellSize = DEFAULT_CELL_SIZE);
+
+	// Same as Init, using GetTerrainMinX/MaxX/MinZ/MaxZ for the bounds.
+	void InitFromTerrain(float cellSize = DEFAULT_CELL_SIZE);
+
+	bool IsInitialized() const { return !m_CellStart.empty(); }
+
+	// Buckets every entity in the table by cell. Lays the grid out over
+	// the terrain if Init hasn't been called yet.
+	void Build(const EntityTable& table);
+
+	// Calls fn(index, distSq) for every entity within radius of center.
+	template <typename Fn>
+	void ForEachInRadius(const Vector& center, float radius, Fn&& fn) const;
+
+	// Appends the indices of every entity within radius of center to out
+	// (unordered). Returns how many were appended.
+	size_t QueryRadius(const Vector& center, float radius, std::vector<uint32_t>& out) const;
+
+	// Counts entities within radius of center that pass pred(index).
+	template <typename Pred>
+	int CountInRadius(const Vector& center, float radius, Pred&& pred) const;
+
+	// Returns the index of the closest entity within maxDist of center that
+	// passes pred(index), or -1 if there isn't one. e.g.
+	//
+	// int i = grid.FindNearest(pos, 450.0f, [&](uint32_t j) { return table.GetTeamNum(j) == 2 && table.IsAlive(j); });
+	template <typename Pred>
+	int FindNearest(const Vector& center, float maxDist, Pred&& pred) const;
+
+	// Fills out with the indices of up to k entities within maxDist of
+	// center that pass pred(index), closest first. Returns the count.
+	// Keeps its heap in scratch, so a caller running a query per unit can
+	// hold on to one buffer and not allocate after the first.
+	template <typename Pred>
+	size_t FindKNearest(const Vector& center, size_t k, float maxDist, std::vector<uint32_t>& out, std::vector<Neighbor>& scratch, Pred&& pred) const;
+
+	template <typename Pred>
+	size_t FindKNearest(const Vector& center, size_t k, float maxDist, std::vector<uint32_t>& out, Pred&& pred) const
+	{
+		std::vector<Neighbor> scratch;
+		return FindKNearest(center, k, maxDist, out, scratch, std::forward<Pred>(pred));
+	}
+
+	size_t FindKNearest(const Vector& center, size_t k, float maxDist, std::vector<uint32_t>& out) const
+	{
+		return FindKNearest(center, k, maxDist, out, [](uint32_t) { return true; });
+	}
+
+	float GetCellSize() const { return m_CellSize; }
+	int GetCellsX() const { return m_CellsX; }
+	int GetCellsZ() const { return m_CellsZ; }
+
+private:
+	int CellX(float x) const { return std::clamp(static_cast<int>((x - m_MinX) * m_InvCellSize), 0, m_CellsX - 1); }
+	int CellZ(float z) const { return std::clamp(static_cast<int>((z - m_MinZ) * m_InvCellSize), 0, m_CellsZ - 1); }
+
+	// Visits every entity in cell (cx, cz). Cell must be in range.
+	template <typename Fn>
+	void ForEachInCell(int cx, int cz, Fn&& fn) const
+	{
+		const int cell = cz * m_CellsX + cx;
+		for (uint32_t s = m_CellStart[cell]; s < m_CellStart[cell + 1]; ++s)
+			fn(s);
+	}
+
+	// Visits the cells on the square ring at Chebyshev distance r around
+	// (cx, cz), clipped to the grid. Returns false once the ring lies
+	// completely outside the grid.
+	template <typename Fn>
+	bool ForEachCellInRing(int cx, int cz, int r, Fn&& fn) const;
+
+	float m_MinX = 0.0f;
+	float m_MinZ = 0.0f;
+	float m_CellSize = DEFAULT_CELL_SIZE;
+	float m_InvCellSize = 1.0f / DEFAULT_CELL_SIZE;
+	int m_CellsX = 0;
+	int m_CellsZ = 0;
+
+	// m_CellStart[c]..m_CellStart[c + 1] is the slot range of cell c in
+	// the sorted arrays below.
+	std::vector<uint32_t> m_CellStart;
+	std::vector<uint32_t> m_SortedIndex;
+	std::vector<float> m_SortedX;
+	std::vector<float> m_SortedZ;
+
+	// Scratch for Build, kept around so rebuilding doesn't allocate
+	std::vector<uint32_t> m_EntityCell;
+};
+
+template <typename Fn>
+void SpatialGrid::ForEachInRadius(const Vector& center, float radius, Fn&& fn) const
+{
+	if (!IsInitialized() || radius < 0.0f)
+		return;
+
+	const float radiusSq = radius * radius;
+	const int x0 = CellX(center.x - radius), x1 = CellX(center.x + radius);
+	const int z0 = CellZ(center.z - radius), z1 = CellZ(center.z + radius);
+
+	for (int cz = z0; cz <= z1; ++cz)
+	{
+		for (int cx = x0; cx <= x1; ++cx)
+		{
+			ForEachInCell(cx, cz, [&](uint32_t s)
+			{
+				const float dx = m_SortedX[s] - center.x;
+				const float dz = m_SortedZ[s] - center.z;
+				const float distSq = dx * dx + dz * dz;
+				if (distSq <= radiusSq)
+					fn(m_SortedIndex[s], distSq);
+			});
+		}
+	}
+}
+
+template <typename Pred>
+int SpatialGrid::CountInRadius(const Vector& center, float radius, Pred&& pred) const
+{
+	int count = 0;
+	ForEachInRadius(center, radius, [&](uint32_t i, float)
+	{
+		if (pred(i))
+			++count;
+	});
+	return count;
+}
+
+template <typename Fn>
+bool SpatialGrid::ForEachCellInRing(int cx, int cz, int r, Fn&& fn) const
+{
+	const int x0 = cx - r, x1 = cx + r;
+	const int z0 = cz - r, z1 = cz + r;
+	if (x0 < 0 && z0 < 0 && x1 >= m_CellsX && z1 >= m_CellsZ)
+		return false;
+
+	if (r == 0)
+	{
+		fn(cx, cz);
+		return true;
+	}
+
+	const int clipX0 = std::max(x0, 0), clipX1 = std::min(x1, m_CellsX - 1);
+	const int clipZ0 = std::max(z0 + 1, 0), clipZ1 = std::min(z1 - 1, m_CellsZ - 1);
+
+	// Top and bottom rows, including corners
+	for (int x = clipX0; x <= clipX1; ++x)
+	{
+		if (z0 >= 0)
+			fn(x, z0);
+		if (z1 < m_CellsZ)
+			fn(x, z1);
+	}
+	// Left and right columns, excluding corners
+	for (int z = clipZ0; z <= clipZ1; ++z)
+	{
+		if (x0 >= 0)
+			fn(x0, z);
+		if (x1 < m_CellsX)
+			fn(x1, z);
+	}
+	return true;
+}
+
+template <typename Pred>
+int SpatialGrid::FindNearest(const Vector& center, float maxDist, Pred&& pred) const
+{
+	if (!IsInitialized())
+		return -1;
+
+	const int cx = CellX(center.x), cz = CellZ(center.z);
+	float bestSq = maxDist * maxDist;
+	int best = -1;
+
+	// Expand outward ring by ring. Anything outside rings 0..r is at least
+	// r cells away, so once the best hit beats that we can stop.
+	for (int r = 0; ; ++r)
+	{
+		const bool inGrid = ForEachCellInRing(cx, cz, r, [&](int x, int z)
+		{
+			ForEachInCell(x, z, [&](uint32_t s)
+			{
+				const float dx = m_SortedX[s] - center.x;
+				const float dz = m_SortedZ[s] - center.z;
+				const float distSq = dx * dx + dz * dz;
+				if (distSq <= bestSq && pred(m_SortedIndex[s]))
+				{
+					// Break ties on index so results don't depend on bucket order
+					if (distSq < bestSq || best < 0 || m_SortedIndex[s] < static_cast<uint32_t>(best))
+					{
+						bestSq = distSq;
+						best = static_cast<int>(m_SortedIndex[s]);
+					}
+				}
+			});
+		});
+
+		const float reach = r * m_CellSize;
+		if (!inGrid || reach * reach >= bestSq)
+			break;
+	}
+
+	return best;
+}
+
+template <typename Pred>
+size_t SpatialGrid::FindKNearest(const Vector& center, size_t k, float maxDist, std::vector<uint32_t>& out, std::vector<Neighbor>& scratch, Pred&& pred) const
+{
+	out.clear();
+	if (!IsInitialized() || k == 0)
+		return 0;
+
+	// Max-heap on (distSq, index) holding the best k so far
+	std::vector<Neighbor>& heap = scratch;
+	heap.clear();
+	heap.reserve(k + 1);
+
+	const int cx = CellX(center.x), cz = CellZ(center.z);
+	const float maxSq = maxDist * maxDist;
+
+	for (int r = 0; ; ++r)
+	{
+		const bool inGrid = ForEachCellInRing(cx, cz, r, [&](int x, int z)
+		{
+			ForEachInCell(x, z, [&](uint32_t s)
+			{
+				const float dx = m_SortedX[s] - center.x;
+				const float dz = m_SortedZ[s] - center.z;
+				const Neighbor hit(dx * dx + dz * dz, m_SortedIndex[s]);
+				if (hit.first > maxSq || (heap.size() == k && !(hit < heap.front())))
+					return;
+				if (!pred(hit.second))
+					return;
+
+				heap.push_back(hit);
+				std::push_heap(heap.begin(), heap.end());
+				if (heap.size() > k)
+				{
+					std::pop_heap(heap.begin(), heap.end());
+					heap.pop_back();
+				}
+			});
+		});
+
+		const float reach = r * m_CellSize;
+		if (!inGrid || reach * reach >= maxSq || (heap.size() == k && reach * reach >= heap.front().first))
+			break;
+	}
+
+	std::sort_heap(heap.begin(), heap.end());
+	for (const auto& hit : heap)
+		out.push_back(hit.second);
+	return out.size();
+}
+
+#endif
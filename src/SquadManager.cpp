@@ -0,0 +1,299 @@
+#include "SquadManager.h"
+
+#include "EntityTable.h"
+#include "OrderBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t SQUAD_SAVE_TAG = 'SQAD';
+	// Bump this whenever the Save() layout changes
+	constexpr uint32_t SQUAD_SAVE_VERSION = 1;
+}
+
+SquadId SquadManager::CreateSquad()
+{
+	SquadId squad;
+	if (!m_FreeSquads.empty())
+	{
+		squad = m_FreeSquads.back();
+		m_FreeSquads.pop_back();
+	}
+	else if (m_Squads.size() < INVALID_SQUAD_ID)
+	{
+		squad = static_cast<SquadId>(m_Squads.size());
+		m_Squads.emplace_back();
+	}
+	else
+	{
+		return INVALID_SQUAD_ID;
+	}
+
+	m_Squads[squad].active = true;
+	return squad;
+}
+
+void SquadManager::DestroySquad(SquadId squad)
+{
+	if (!IsValid(squad))
+		return;
+
+	Squad& s = m_Squads[squad];
+	for (Handle h : s.handles)
+		m_Membership.erase(h);
+	s.handles.clear();
+	s.slots.clear();
+	s.positions.clear();
+	s.active = false;
+	m_FreeSquads.push_back(squad);
+}
+
+bool SquadManager::Add(SquadId squad, Handle h)
+{
+	if (!IsValid(squad) || h == 0)
+		return false;
+	if (GetSquad(h) == squad)
+		return true;
+
+	Remove(h);
+
+	Squad& s = m_Squads[squad];
+
+	// Lowest slot nobody's using, so survivors keep their place in formation
+	std::pmr::vector<bool> used(s.slots.size() + 1, m_Scratch);
+	for (uint16_t slot : s.slots)
+	{
+		if (slot < used.size())
+			used[slot] = true;
+	}
+	const uint16_t slot = static_cast<uint16_t>(std::find(used.begin(), used.end(), false) - used.begin());
+
+	m_Membership[h] = { squad, static_cast<uint32_t>(s.handles.size()) };
+	s.handles.push_back(h);
+	s.slots.push_back(slot);
+	Vector pos;
+	GetPosition(h, pos);
+	s.positions.push_back(pos);
+	return true;
+}
+
+void SquadManager::Remove(Handle h)
+{
+	auto it = m_Membership.find(h);
+	if (it == m_Membership.end())
+		return;
+
+	const Membership membership = it->second;
+	m_Membership.erase(it);
+	RemoveAt(membership.squad, membership.index);
+}
+
+std::span<const Handle> SquadManager::GetMembers(SquadId squad) const
+{
+	if (!IsValid(squad))
+		return {};
+	return m_Squads[squad].handles;
+}
+
+std::span<const uint16_t> SquadManager::GetSlots(SquadId squad) const
+{
+	if (!IsValid(squad))
+		return {};
+	return m_Squads[squad].slots;
+}
+
+std::span<const Vector> SquadManager::GetPositions(SquadId squad) const
+{
+	if (!IsValid(squad))
+		return {};
+	return m_Squads[squad].positions;
+}
+
+Vector SquadManager::GetCenter(SquadId squad) const
+{
+	Vector center(0.0f, 0.0f, 0.0f);
+	if (!IsValid(squad) || m_Squads[squad].positions.empty())
+		return center;
+
+	const std::vector<Vector>& positions = m_Squads[squad].positions;
+	for (const Vector& pos : positions)
+	{
+		center.x += pos.x;
+		center.y += pos.y;
+		center.z += pos.z;
+	}
+	const float inv = 1.0f / static_cast<float>(positions.size());
+	return Vector(center.x * inv, center.y * inv, center.z * inv);
+}
+
+void SquadManager::Refresh(const EntityTable& table)
+{
+	const std::span<const Vector> positions = table.GetPositions();
+	for (Squad& s : m_Squads)
+	{
+		for (size_t i = 0; i < s.handles.size(); ++i)
+		{
+			const int index = table.Find(s.handles[i]);
+			if (index >= 0)
+				s.positions[i] = positions[index];
+		}
+	}
+}
+
+void SquadManager::Move(SquadId squad, const Vector& pos, float spacing, int priority)
+{
+	if (!IsValid(squad))
+		return;
+
+	const Squad& s = m_Squads[squad];
+	if (spacing <= 0.0f)
+	{
+		for (Handle h : s.handles)
+			m_Orders.Goto(h, pos, priority);
+		return;
+	}
+
+	// Grid sized by the highest slot rather than the member count, so
+	// losing a unit doesn't shuffle everyone else's spot
+	const int slotCount = s.slots.empty() ? 0 : *std::max_element(s.slots.begin(), s.slots.end()) + 1;
+	const int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(slotCount)))));
+	const int rows = (slotCount + columns - 1) / columns;
+	for (size_t i = 0; i < s.handles.size(); ++i)
+	{
+		const int column = s.slots[i] % columns;
+		const int row = s.slots[i] / columns;
+		const Vector slotPos(
+			pos.x + (column - (columns - 1) * 0.5f) * spacing,
+			pos.y,
+			pos.z + (row - (rows - 1) * 0.5f) * spacing);
+		m_Orders.Goto(s.handles[i], slotPos, priority);
+	}
+}
+
+void SquadManager::Attack(SquadId squad, Handle target, int priority)
+{
+	if (!IsValid(squad))
+		return;
+	for (Handle h : m_Squads[squad].handles)
+		m_Orders.Attack(h, target, priority);
+}
+
+void SquadManager::Defend(SquadId squad, int priority)
+{
+	if (!IsValid(squad))
+		return;
+	for (Handle h : m_Squads[squad].handles)
+		m_Orders.Defend(h, priority);
+}
+
+void SquadManager::Patrol(SquadId squad, ConstName path, int priority)
+{
+	if (!IsValid(squad))
+		return;
+	for (Handle h : m_Squads[squad].handles)
+		m_Orders.Patrol(h, path, priority);
+}
+
+void SquadManager::Clear()
+{
+	m_Squads.clear();
+	m_FreeSquads.clear();
+	m_Membership.clear();
+}
+
+void SquadManager::Save(SaveWriter& writer) const
+{
+	writer.BeginSection(SQUAD_SAVE_TAG, SQUAD_SAVE_VERSION);
+	writer.Write(static_cast<uint32_t>(m_Squads.size()));
+	for (const Squad& s : m_Squads)
+	{
+		writer.Write(static_cast<uint8_t>(s.active));
+		writer.WriteHandles(s.handles);
+		writer.WriteArray(std::span<const uint16_t>(s.slots));
+	}
+	writer.EndSection();
+}
+
+bool SquadManager::Load(SaveReader& reader)
+{
+	Clear();
+
+	// Saves from before squads existed just don't have any
+	uint32_t version = 0;
+	if (!reader.OpenSection(SQUAD_SAVE_TAG, version))
+		return true;
+	if (version != SQUAD_SAVE_VERSION)
+		return false;
+
+	uint32_t count = 0;
+	if (!reader.Read(count) || count > INVALID_SQUAD_ID)
+		return false;
+
+	// Sized up front: the reader holds on to the handle vectors until PostLoad
+	m_Squads.resize(count);
+	for (SquadId squad = 0; squad < count; ++squad)
+	{
+		Squad& s = m_Squads[squad];
+		uint8_t active = 0;
+		if (!reader.Read(active) || !reader.ReadHandles(s.handles) || !reader.ReadArray(s.slots) || s.slots.size() != s.handles.size())
+			return false;
+
+		s.active = active != 0;
+		s.positions.assign(s.handles.size(), Vector(0.0f, 0.0f, 0.0f));
+		if (!s.active)
+			m_FreeSquads.push_back(squad);
+	}
+	return true;
+}
+
+void SquadManager::PostLoad()
+{
+	// Units that didn't survive the load come back as 0
+	for (Squad& s : m_Squads)
+	{
+		for (size_t i = s.handles.size(); i-- > 0;)
+		{
+			if (s.handles[i] == 0)
+			{
+				s.handles[i] = s.handles.back();
+				s.slots[i] = s.slots.back();
+				s.handles.pop_back();
+				s.slots.pop_back();
+			}
+		}
+		s.positions.resize(s.handles.size());
+		for (size_t i = 0; i < s.handles.size(); ++i)
+			GetPosition(s.handles[i], s.positions[i]);
+	}
+
+	RebuildMembership();
+}
+
+void SquadManager::RemoveAt(SquadId squad, uint32_t index)
+{
+	Squad& s = m_Squads[squad];
+	const uint32_t last = static_cast<uint32_t>(s.handles.size() - 1);
+	if (index != last)
+	{
+		s.handles[index] = s.handles[last];
+		s.slots[index] = s.slots[last];
+		s.positions[index] = s.positions[last];
+		m_Membership[s.handles[index]].index = index;
+	}
+	s.handles.pop_back();
+	s.slots.pop_back();
+	s.positions.pop_back();
+}
+
+void SquadManager::RebuildMembership()
+{
+	m_Membership.clear();
+	for (size_t squad = 0; squad < m_Squads.size(); ++squad)
+	{
+		const Squad& s = m_Squads[squad];
+		for (size_t i = 0; i < s.handles.size(); ++i)
+			m_Membership[s.handles[i]] = { static_cast<SquadId>(squad), static_cast<uint32_t>(i) };
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef _SquadManager_
+#define _SquadManager_
+
+#include <ScriptUtils.h>
+
+#include "SaveBuffer.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class EntityTable;
+class OrderBuffer;
+
+// Identifies a squad. Ids of destroyed squads get reused.
+typedef uint16_t SquadId;
+const SquadId INVALID_SQUAD_ID = 0xFFFF;
+
+// Script-side unit groups, separate from the game's command bar groups
+// (SetGroup/GetGroup). Each squad keeps its members' handles, formation
+// slots and cached positions in parallel arrays, and removing a member
+// swaps the last one into its place, so loops over a squad only ever see
+// live members.
+//
+// Bulk orders go through the OrderBuffer, so ordering a squad every tick
+// only reaches the game for members whose orders actually changed.
+class SquadManager
+{
+public:
+	// Add takes its temporary buffer from scratch, e.g. the mission's FrameArena
+	explicit SquadManager(OrderBuffer& orders, std::pmr::memory_resource* scratch = std::pmr::get_default_resource())
+		: m_Orders(orders), m_Scratch(scratch) {}
+
+	SquadId CreateSquad();
+
+	// Releases every member and frees the id.
+	void DestroySquad(SquadId squad);
+
+	bool IsValid(SquadId squad) const { return squad < m_Squads.size() && m_Squads[squad].active; }
+
+	// Adds h to squad, taking it out of whatever squad it was in. Takes the
+	// lowest free formation slot.
+	bool Add(SquadId squad, Handle h);
+
+	// Takes h out of its squad. Call from DeleteObject and ObjectKilled.
+	void Remove(Handle h);
+
+	// The squad h is in, or INVALID_SQUAD_ID.
+	SquadId GetSquad(Handle h) const
+	{
+		auto it = m_Membership.find(h);
+		return it != m_Membership.end() ? it->second.squad : INVALID_SQUAD_ID;
+	}
+
+	size_t GetSize(SquadId squad) const { return IsValid(squad) ? m_Squads[squad].handles.size() : 0; }
+
+	std::span<const Handle> GetMembers(SquadId squad) const;
+	// Formation slot of each member, same order as GetMembers
+	std::span<const uint16_t> GetSlots(SquadId squad) const;
+	// Positions as of the last Refresh, same order as GetMembers
+	std::span<const Vector> GetPositions(SquadId squad) const;
+
+	// Average member position as of the last Refresh.
+	Vector GetCenter(SquadId squad) const;
+
+	// Copies member positions out of the snapshot. Call once per Update
+	// after the EntityTable refresh.
+	void Refresh(const EntityTable& table);
+
+	// Sends the whole squad to pos. With spacing > 0, members spread out
+	// in a square grid around pos by formation slot.
+	void Move(SquadId squad, const Vector& pos, float spacing = 0.0f, int priority = 1);
+	void Attack(SquadId squad, Handle target, int priority = 1);
+	void Defend(SquadId squad, int priority = 1);
+	void Patrol(SquadId squad, ConstName path, int priority = 1);
+
+	void Clear();
+
+	// Saved as the 'SQAD' section. Call Save/Load from the mission's
+	// Save/Load, and PostLoad after the reader has converted handles.
+	void Save(SaveWriter& writer) const;
+	bool Load(SaveReader& reader);
+	void PostLoad();
+
+private:
+	struct Squad
+	{
+		bool active = false;
+		std::vector<Handle> handles;
+		std::vector<uint16_t> slots;
+		std::vector<Vector> positions;
+	};
+
+	struct Membership
+	{
+		SquadId squad;
+		uint32_t index;
+	};
+
+	void RemoveAt(SquadId squad, uint32_t index);
+
+	// Rebuilds m_Membership from the squads.
+	void RebuildMembership();
+
+	OrderBuffer& m_Orders;
+	std::pmr::memory_resource* m_Scratch;
+	std::vector<Squad> m_Squads;
+	std::vector<SquadId> m_FreeSquads;
+	std::unordered_map<Handle, Membership> m_Membership;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "TargetAssigner.h"
+
+#include "EntityTable.h"
+#include "OrderBuffer.h"
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+size_t TargetAssigner::Solve(const EntityTable& table, const SpatialGrid& grid, std::span<const Handle> attackers)
+{
+	++m_Stats.solves;
+	m_AlliesKnown = 0;
+
+	// Put back only the entries the last solve touched
+	for (uint32_t index : m_AttackerIndices)
+		m_AttackerSlots[index] = NO_SLOT;
+	for (const Target& target : m_Targets)
+		m_TargetSlots[target.index] = NO_SLOT;
+	if (m_TargetSlots.size() < table.Size())
+	{
+		m_TargetSlots.resize(table.Size(), NO_SLOT);
+		m_AttackerSlots.resize(table.Size(), NO_SLOT);
+	}
+
+	m_AttackerIndices.clear();
+	m_CurrentTargets.clear();
+	m_Targets.clear();
+	m_Pairs.clear();
+
+	const auto handles = table.GetHandles();
+	const auto positions = table.GetPositions();
+	const auto teams = table.GetTeams();
+	const auto healths = table.GetHealths();
+	const auto alive = table.GetAlive();
+
+	for (Handle h : attackers)
+	{
+		const int index = table.Find(h);
+		if (index < 0 || !alive[index] || teams[index] < 0 || teams[index] >= MAX_TEAMS)
+		{
+			m_Assignments.erase(h);
+			continue;
+		}
+		if (m_AttackerSlots[index] != NO_SLOT)
+			continue;
+		m_AttackerSlots[index] = static_cast<uint32_t>(m_AttackerIndices.size());
+		m_AttackerIndices.push_back(static_cast<uint32_t>(index));
+		m_CurrentTargets.push_back(GetTarget(h));
+	}
+
+	// Every attacker's closest enemies. Team 0 is never a target.
+	const float maxRange = std::max(m_Settings.maxRange, 1.0f);
+	const size_t k = static_cast<size_t>(std::max(m_Settings.candidates, 1));
+	for (uint32_t a = 0; a < m_AttackerIndices.size(); ++a)
+	{
+		const uint32_t index = m_AttackerIndices[a];
+		const TeamNum team = teams[index];
+		grid.FindKNearest(positions[index], k, maxRange, m_Nearby, m_NearbyHeap, [&](uint32_t j)
+		{
+			return alive[j] && teams[j] > 0 && teams[j] < MAX_TEAMS && !IsAllied(team, teams[j]);
+		});
+
+		for (uint32_t j : m_Nearby)
+			m_Pairs.push_back({ 0.0f, a, AddTarget(table, j) });
+	}
+	m_Stats.pairs += m_Pairs.size();
+
+	for (Pair& pair : m_Pairs)
+	{
+		const uint32_t attacker = m_AttackerIndices[pair.attacker];
+		const Target& target = m_Targets[pair.target];
+		const Vector& from = positions[attacker];
+		const Vector& to = positions[target.index];
+		const float distance = std::sqrt((to.x - from.x) * (to.x - from.x) + (to.z - from.z) * (to.z - from.z));
+
+		float score = m_Settings.distanceWeight * (1.0f - std::min(distance / maxRange, 1.0f));
+		score += m_Settings.healthWeight * (1.0f - std::clamp(healths[target.index], 0.0f, 1.0f));
+		if (target.aimingAt >= 0 && IsAllied(teams[attacker], target.aimingAt))
+			score += m_Settings.threatWeight;
+		if (m_CurrentTargets[pair.attacker] == handles[target.index])
+			score += m_Settings.stickiness;
+		pair.score = score;
+	}
+
+	// Best first. Ties break on position in the inputs, so every machine
+	// in a multiplayer game hands out the same targets.
+	std::sort(m_Pairs.begin(), m_Pairs.end(), [](const Pair& a, const Pair& b)
+	{
+		if (a.score != b.score)
+			return a.score > b.score;
+		if (a.attacker != b.attacker)
+			return a.attacker < b.attacker;
+		return a.target < b.target;
+	});
+
+	std::vector<Handle>& chosen = m_Chosen;
+	chosen.assign(m_AttackerIndices.size(), 0);
+	for (const Pair& pair : m_Pairs)
+	{
+		Target& target = m_Targets[pair.target];
+		if (chosen[pair.attacker] != 0 || target.load >= target.capacity)
+			continue;
+		// About to fill up, so find out who else is on it
+		if (!target.othersCounted && target.load + 1 >= target.capacity)
+		{
+			CountOthers(table, target);
+			if (target.load >= target.capacity)
+				continue;
+		}
+		++target.load;
+		chosen[pair.attacker] = handles[target.index];
+	}
+
+	size_t assigned = 0;
+	for (size_t a = 0; a < m_AttackerIndices.size(); ++a)
+	{
+		const Handle h = handles[m_AttackerIndices[a]];
+		const Handle target = chosen[a];
+		if (target == 0)
+		{
+			m_Assignments.erase(h);
+			continue;
+		}
+
+		++assigned;
+		m_Assignments[h] = target;
+		const bool changed = target != m_CurrentTargets[a];
+		if (changed)
+			++m_Stats.retargeted;
+
+		// Attack goes out every solve and the OrderBuffer drops it while the unit is still on it
+		if (m_Settings.mode == ASSIGN_ATTACK)
+			m_Orders.Attack(h, target, m_Settings.priority);
+		else if (changed)
+			SetTarget(h, target);
+	}
+
+	m_Stats.assigned += assigned;
+	return assigned;
+}
+
+uint32_t TargetAssigner::AddTarget(const EntityTable& table, uint32_t index)
+{
+	if (m_TargetSlots[index] != NO_SLOT)
+		return m_TargetSlots[index];
+
+	const Handle h = table.GetHandle(index);
+	const int maxAttackers = std::max(m_Settings.maxAttackersPerTarget, 1);
+	const float health = std::clamp(table.GetHealth(index), 0.0f, 1.0f);
+
+	Target target{};
+	target.index = index;
+	target.capacity = std::clamp(static_cast<int>(std::ceil(health * maxAttackers)), 1, maxAttackers);
+	target.load = 0;
+	target.othersCounted = false;
+	target.aimingAt = -1;
+
+	const Handle aim = GetTarget(h);
+	const int aimIndex = aim != 0 ? table.Find(aim) : -1;
+	if (aimIndex >= 0)
+		target.aimingAt = table.GetTeamNum(aimIndex);
+
+	m_TargetSlots[index] = static_cast<uint32_t>(m_Targets.size());
+	m_Targets.push_back(target);
+	return m_TargetSlots[index];
+}
+
+void TargetAssigner::CountOthers(const EntityTable& table, Target& target)
+{
+	++m_Stats.targetingQueries;
+	target.othersCounted = true;
+
+	// Our attackers get handed out again this solve, anyone else takes up a slot
+	for (Handle h : QueryWhoIsTargeting(m_Targeting, table.GetHandle(target.index)))
+	{
+		const int index = table.Find(h);
+		if (index < 0 || m_AttackerSlots[index] == NO_SLOT)
+			++target.load;
+	}
+}
+
+bool TargetAssigner::IsAllied(TeamNum a, TeamNum b)
+{
+	if (a == b)
+		return true;
+	if (a < 0 || a >= MAX_TEAMS || b < 0 || b >= MAX_TEAMS)
+		return false;
+
+	if (!(m_AlliesKnown & (1u << a)))
+	{
+		uint32_t mask = 1u << a;
+		for (int t = 0; t < MAX_TEAMS; ++t)
+		{
+			if (t != a && IsTeamAllied(a, t))
+				mask |= 1u << t;
+		}
+		m_Allies[a] = mask;
+		m_AlliesKnown |= 1u << a;
+	}
+	return (m_Allies[a] & (1u << b)) != 0;
+}
@@ -0,0 +1,154 @@
+#ifndef _TargetAssigner_
+#define _TargetAssigner_
+
+#include <ScriptUtils.h>
+
+#include "ExportBuffer.h"
+#include "SpatialGrid.h"
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class EntityTable;
+class OrderBuffer;
+
+// Picks targets for a group of attackers together, so they spread over
+// the enemies nearby instead of all going for whichever one
+// GetNearestEnemy returns first.
+//
+// Each solve scores every attacker against its closest few enemies from
+// the SpatialGrid (closer, more damaged, and shooting at our side are
+// better; keeping the current target gets a bonus), then hands out
+// targets best score first with a cap on attackers per target that
+// scales with its health. Our attackers' current targets come from
+// GetTarget and keep the bonus. Anyone else on a target counts against
+// the cap, but WhoIsTargeting goes over every object, so it's only asked
+// once a target is about to fill up.
+//
+// Call every tick or every few turns (e.g. from a TimerWheel timer), with
+// the table refreshed and the grid built this turn. Orders go out through
+// the OrderBuffer as Attack, or straight to SetTarget when only the
+// turret/aim target should change.
+class TargetAssigner
+{
+public:
+	enum OrderMode
+	{
+		// OrderBuffer::Attack, which changes what the unit is doing
+		ASSIGN_ATTACK,
+		// SetTarget, for units that should keep their orders and just aim
+		ASSIGN_SET_TARGET,
+	};
+
+	struct Settings
+	{
+		// Enemies further than this aren't considered
+		float maxRange = 400.0f;
+		// Closest enemies scored per attacker
+		int candidates = 8;
+		// Cap on attackers per target at full health
+		int maxAttackersPerTarget = 3;
+
+		float distanceWeight = 1.0f;
+		float healthWeight = 0.5f;
+		float threatWeight = 0.5f;
+		float stickiness = 0.3f;
+
+		OrderMode mode = ASSIGN_ATTACK;
+		int priority = 1;
+	};
+
+	explicit TargetAssigner(OrderBuffer& orders) : m_Orders(orders) {}
+
+	void SetSettings(const Settings& settings) { m_Settings = settings; }
+	const Settings& GetSettings() const { return m_Settings; }
+
+	// Assigns targets to attackers (handles in table) and sends the orders.
+	// Returns how many attackers got a target.
+	size_t Solve(const EntityTable& table, const SpatialGrid& grid, std::span<const Handle> attackers);
+
+	// Target from the last Solve, or 0.
+	Handle GetAssignment(Handle attacker) const
+	{
+		auto it = m_Assignments.find(attacker);
+		return it != m_Assignments.end() ? it->second : 0;
+	}
+
+	// Forgets h as attacker. Call from DeleteObject.
+	void Remove(Handle h) { m_Assignments.erase(h); }
+
+	// Call from PostLoad since handles change.
+	void Clear() { m_Assignments.clear(); }
+
+	struct Stats
+	{
+		uint64_t solves;
+		// Attacker/target pairs scored
+		uint64_t pairs;
+		uint64_t assigned;
+		// Assignments that differed from the attacker's current target
+		uint64_t retargeted;
+		// WhoIsTargeting calls, for targets about to fill up
+		uint64_t targetingQueries;
+	};
+
+	const Stats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = {}; }
+
+private:
+	static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+	struct Target
+	{
+		uint32_t index;
+		int capacity;
+		int load;
+		// Whether load includes units that aren't our attackers yet
+		bool othersCounted;
+		// Team of whatever this target is shooting at, or -1
+		TeamNum aimingAt;
+	};
+
+	struct Pair
+	{
+		float score;
+		uint32_t attacker;
+		uint32_t target;
+	};
+
+	// Slot in m_Targets for table index, filling it in on first sight
+	uint32_t AddTarget(const EntityTable& table, uint32_t index);
+	// Adds whoever else is on target to its load
+	void CountOthers(const EntityTable& table, Target& target);
+
+	bool IsAllied(TeamNum a, TeamNum b);
+
+	OrderBuffer& m_Orders;
+	Settings m_Settings;
+
+	std::unordered_map<Handle, Handle> m_Assignments;
+
+	// Scratch, kept between solves for the capacity
+	std::vector<uint32_t> m_AttackerIndices;
+	std::vector<Handle> m_CurrentTargets;
+	std::vector<Target> m_Targets;
+	// By table index: slot in m_Targets / m_AttackerIndices, or NO_SLOT
+	std::vector<uint32_t> m_TargetSlots;
+	std::vector<uint32_t> m_AttackerSlots;
+	std::vector<Pair> m_Pairs;
+	std::vector<uint32_t> m_Nearby;
+	std::vector<SpatialGrid::Neighbor> m_NearbyHeap;
+	// Starts big enough for most targets, so WhoIsTargeting is usually one call
+	ExportBuffer<Handle> m_Targeting{ 16 };
+	std::vector<Handle> m_Chosen;
+
+	// Alliance cache for the current solve, bit b of m_Allies[a] set if a and b are allied
+	uint32_t m_Allies[MAX_TEAMS] = {};
+	uint32_t m_AlliesKnown = 0;
+
+	Stats m_Stats{};
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "TerrainCache.h"
+
+#include "ExportBuffer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace
+{
+	constexpr uint32_t TERRAIN_FILE_MAGIC = 'HFLD';
+	// Bump this whenever FileHeader or the sample layout changes
+	constexpr uint32_t TERRAIN_FILE_VERSION = 1;
+
+	// Big enough for most output paths, so GetOutputPath is one call
+	constexpr size_t OUTPUT_PATH_CAPACITY = 260;
+
+	// Probe heights per side that go into the key
+	constexpr int KEY_PROBES = 17;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		float minX;
+		float minZ;
+		float cellSize;
+		int32_t samplesX;
+		int32_t samplesZ;
+		uint32_t reserved;
+	};
+
+	// FNV-1a
+	uint64_t Hash(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	constexpr uint64_t HASH_SEED = 0xCBF29CE484222325ull;
+}
+
+void TerrainCache::Load(float cellSize)
+{
+	Layout(cellSize);
+
+	const uint64_t key = ComputeKey();
+	const std::filesystem::path path = GetCachePath(key);
+	if (!path.empty() && MapFile(path, key))
+		return;
+
+	Sample(cellSize);
+	if (!path.empty())
+		WriteFile(path, key);
+}
+
+void TerrainCache::Sample(float cellSize)
+{
+	Layout(cellSize);
+
+	m_Samples.resize(static_cast<size_t>(m_SamplesX) * m_SamplesZ);
+	for (int j = 0; j < m_SamplesZ; ++j)
+	{
+		const float z = m_MinZ + j * m_CellSize;
+		float* row = m_Samples.data() + static_cast<size_t>(j) * m_SamplesX;
+		for (int i = 0; i < m_SamplesX; ++i)
+			row[i] = GetTerrainHeight(m_MinX + i * m_CellSize, z);
+	}
+	m_Heights = m_Samples.data();
+}
+
+Vector TerrainCache::GetNormal(float x, float z) const
+{
+	const float dx = GetHeight(x + m_CellSize, z) - GetHeight(x - m_CellSize, z);
+	const float dz = GetHeight(x, z + m_CellSize) - GetHeight(x, z - m_CellSize);
+	const float y = 2.0f * m_CellSize;
+	const float inv = 1.0f / std::sqrt(dx * dx + y * y + dz * dz);
+	return Vector(-dx * inv, y * inv, -dz * inv);
+}
+
+void TerrainCache::Layout(float cellSize)
+{
+	m_File.Close();
+	m_Samples.clear();
+	m_Heights = nullptr;
+
+	m_CellSize = cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE;
+	m_InvCellSize = 1.0f / m_CellSize;
+	m_MinX = GetTerrainMinX();
+	m_MinZ = GetTerrainMinZ();
+
+	// At least 2 samples a side so the bilinear read always has a cell
+	m_SamplesX = std::max(2, static_cast<int>(std::ceil((GetTerrainMaxX() - m_MinX) * m_InvCellSize)) + 1);
+	m_SamplesZ = std::max(2, static_cast<int>(std::ceil((GetTerrainMaxZ() - m_MinZ) * m_InvCellSize)) + 1);
+}
+
+uint64_t TerrainCache::ComputeKey() const
+{
+	uint64_t hash = HASH_SEED;
+
+	const char* trn = GetMapTRNFilename();
+	if (trn)
+		hash = Hash(hash, trn, std::strlen(trn));
+
+	const float layout[] = { m_MinX, m_MinZ, m_CellSize, GetTerrainMaxX(), GetTerrainMaxZ() };
+	hash = Hash(hash, layout, sizeof(layout));
+
+	// A few hundred heights spread over the map catch most edits to it
+	const float maxX = m_MinX + (m_SamplesX - 1) * m_CellSize;
+	const float maxZ = m_MinZ + (m_SamplesZ - 1) * m_CellSize;
+	for (int j = 0; j < KEY_PROBES; ++j)
+	{
+		for (int i = 0; i < KEY_PROBES; ++i)
+		{
+			const float x = m_MinX + (maxX - m_MinX) * i / (KEY_PROBES - 1);
+			const float z = m_MinZ + (maxZ - m_MinZ) * j / (KEY_PROBES - 1);
+			const float height = GetTerrainHeight(x, z);
+			hash = Hash(hash, &height, sizeof(height));
+		}
+	}
+	return hash;
+}
+
+std::filesystem::path TerrainCache::GetCachePath(uint64_t key)
+{
+	ExportBuffer<wchar_t> buffer(OUTPUT_PATH_CAPACITY);
+	const std::wstring_view outputPath = QueryOutputPath(buffer);
+	if (outputPath.empty())
+		return {};
+
+	const char* trn = GetMapTRNFilename();
+	std::string stem = trn ? std::filesystem::path(trn).stem().string() : std::string();
+	if (stem.empty())
+		stem = "map";
+
+	char name[64];
+	std::snprintf(name, sizeof(name), "_%016llx.hfld", static_cast<unsigned long long>(key));
+	return std::filesystem::path(outputPath) / (stem + name);
+}
+
+bool TerrainCache::MapFile(const std::filesystem::path& path, uint64_t key)
+{
+	if (!m_File.Open(path))
+		return false;
+
+	const size_t sampleCount = static_cast<size_t>(m_SamplesX) * m_SamplesZ;
+	FileHeader header{};
+	if (m_File.GetSize() == sizeof(FileHeader) + sampleCount * sizeof(float))
+		std::memcpy(&header, m_File.GetData(), sizeof(header));
+
+	if (header.magic != TERRAIN_FILE_MAGIC || header.version != TERRAIN_FILE_VERSION || header.key != key
+		|| header.minX != m_MinX || header.minZ != m_MinZ || header.cellSize != m_CellSize
+		|| header.samplesX != m_SamplesX || header.samplesZ != m_SamplesZ)
+	{
+		m_File.Close();
+		return false;
+	}
+
+	m_Heights = reinterpret_cast<const float*>(m_File.GetData() + sizeof(FileHeader));
+	return true;
+}
+
+void TerrainCache::WriteFile(const std::filesystem::path& path, uint64_t key) const
+{
+	const FileHeader header{ TERRAIN_FILE_MAGIC, TERRAIN_FILE_VERSION, key, m_MinX, m_MinZ, m_CellSize, m_SamplesX, m_SamplesZ, 0 };
+
+	// Written to the side and renamed over, so a crash halfway never
+	// leaves a bad file under the real name
+	std::filesystem::path temp = path;
+	temp += ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(m_Samples.data()), m_Samples.size() * sizeof(float));
+		if (!file)
+		{
+			file.close();
+			std::error_code ignored;
+			std::filesystem::remove(temp, ignored);
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, path, error);
+	if (error)
+		std::filesystem::remove(temp, error);
+}
@@ -0,0 +1,99 @@
+#ifndef _TerrainCache_
+#define _TerrainCache_
+
+#include <ScriptUtils.h>
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+// The terrain heightfield sampled once with GetTerrainHeight into a grid,
+// so placement and line of sight code can look heights up with a bilinear
+// read instead of an export call each.
+//
+// The grid is saved under GetOutputPath, named after GetMapTRNFilename and
+// a hash of the terrain bounds plus a sparse set of probe heights (so an
+// edited map with the same name gets a new file). Later runs on the same
+// map memory-map that file instead of sampling the whole terrain again.
+class TerrainCache
+{
+public:
+	// Roughly the game's own terrain grid spacing
+	static constexpr float DEFAULT_CELL_SIZE = 8.0f;
+
+	// Maps the saved grid for this map if there is one, otherwise samples
+	// the terrain and saves it. Call from InitialSetup.
+	void Load(float cellSize = DEFAULT_CELL_SIZE);
+
+	// Samples the terrain without looking at or writing the saved file.
+	void Sample(float cellSize = DEFAULT_CELL_SIZE);
+
+	bool IsLoaded() const { return m_Heights != nullptr; }
+
+	// True if the last Load came from the saved file.
+	bool IsMapped() const { return m_File.IsOpen(); }
+
+	// Bilinear height at (x, z). Positions off the map clamp to its edge.
+	float GetHeight(float x, float z) const
+	{
+		const float fx = std::clamp((x - m_MinX) * m_InvCellSize, 0.0f, static_cast<float>(m_SamplesX - 1));
+		const float fz = std::clamp((z - m_MinZ) * m_InvCellSize, 0.0f, static_cast<float>(m_SamplesZ - 1));
+		const int ix = std::min(static_cast<int>(fx), m_SamplesX - 2);
+		const int iz = std::min(static_cast<int>(fz), m_SamplesZ - 2);
+		const float tx = fx - ix;
+		const float tz = fz - iz;
+
+		const float* row = m_Heights + static_cast<size_t>(iz) * m_SamplesX + ix;
+		const float h0 = row[0] + (row[1] - row[0]) * tx;
+		const float h1 = row[m_SamplesX] + (row[m_SamplesX + 1] - row[m_SamplesX]) * tx;
+		return h0 + (h1 - h0) * tz;
+	}
+
+	float GetHeight(const Vector& pos) const { return GetHeight(pos.x, pos.z); }
+
+	// Unit normal from the slope of the grid around (x, z).
+	Vector GetNormal(float x, float z) const;
+
+	float GetCellSize() const { return m_CellSize; }
+	float GetMinX() const { return m_MinX; }
+	float GetMinZ() const { return m_MinZ; }
+	int GetSamplesX() const { return m_SamplesX; }
+	int GetSamplesZ() const { return m_SamplesZ; }
+
+	// Row-major, GetSamplesX() per row, sample (i, j) at (MinX + i * CellSize, MinZ + j * CellSize)
+	std::span<const float> GetSamples() const
+	{
+		return { m_Heights, static_cast<size_t>(m_SamplesX) * m_SamplesZ };
+	}
+
+private:
+	// Sets the grid up over the terrain bounds
+	void Layout(float cellSize);
+
+	// Identifies the terrain the grid was sampled from
+	uint64_t ComputeKey() const;
+
+	// Where the grid for key is saved, or empty if there's no output path
+	static std::filesystem::path GetCachePath(uint64_t key);
+
+	bool MapFile(const std::filesystem::path& path, uint64_t key);
+	void WriteFile(const std::filesystem::path& path, uint64_t key) const;
+
+	float m_MinX = 0.0f;
+	float m_MinZ = 0.0f;
+	float m_CellSize = DEFAULT_CELL_SIZE;
+	float m_InvCellSize = 1.0f / DEFAULT_CELL_SIZE;
+	int m_SamplesX = 0;
+	int m_SamplesZ = 0;
+
+	// Points into either m_Samples or m_File
+	const float* m_Heights = nullptr;
+	std::vector<float> m_Samples;
+	MappedFile m_File;
+};
+
+#endif
@@ -0,0 +1,327 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Bump this whenever the Save() layout changes
+	constexpr uint32_t TIMER_SAVE_TAG = 'TIMR';
+	constexpr uint32_t TIMER_SAVE_VERSION = 1;
+
+	struct SavedTimer
+	{
+		int32_t index;
+		int32_t due;
+		uint32_t seq;
+		int32_t eventId;
+		int32_t param;
+	};
+}
+
+TimerWheel::TimerWheel()
+{
+	for (auto& level : m_Slots)
+		std::fill(std::begin(level), std::end(level), -1);
+}
+
+void TimerWheel::RegisterEvent(int eventId, TimerCallback callback)
+{
+	m_Callbacks[eventId] = callback;
+}
+
+TimerId TimerWheel::Schedule(long turns, int eventId, int param)
+{
+	// Outside Update the wheel's turn is stale, the game may be a turn on
+	const long now = m_InTurn ? m_Turn : GetLockstepTurn();
+	if (m_CurrentTurn < 0)
+		m_CurrentTurn = now;
+
+	const int32_t index = AllocNode();
+	if (index < 0)
+		return INVALID_TIMER_ID;
+
+	Node& node = m_Nodes[index];
+	node.due = std::max(now, m_CurrentTurn) + std::max(turns, 1L);
+	node.seq = m_NextSeq++;
+	node.eventId = eventId;
+	node.param = param;
+	Insert(index);
+
+	return (static_cast<TimerId>(node.generation) << 16) | static_cast<TimerId>(index);
+}
+
+bool TimerWheel::Cancel(TimerId id)
+{
+	const int32_t index = Lookup(id);
+	if (index < 0)
+		return false;
+
+	Unlink(index);
+	FreeNode(index);
+	return true;
+}
+
+long TimerWheel::GetRemainingTurns(TimerId id) const
+{
+	const int32_t index = Lookup(id);
+	return index >= 0 ? m_Nodes[index].due - m_CurrentTurn : -1;
+}
+
+void TimerWheel::Advance(long turn)
+{
+	// Timers the callbacks schedule count from turn, even without BeginTurn
+	const bool inTurn = m_InTurn;
+	const long latched = m_Turn;
+	m_InTurn = true;
+	m_Turn = turn;
+
+	while (m_CurrentTurn < turn)
+	{
+		// Nothing to run, so there's nothing to step through either
+		if (m_PendingCount == 0)
+		{
+			m_CurrentTurn = turn;
+			break;
+		}
+
+		const long t = ++m_CurrentTurn;
+
+		// Whenever a lower level wraps, pull the next slot of the level above
+		// down into it. Highest first, since its timers may land in the slot
+		// being cascaded below it this same turn.
+		int top = 0;
+		while (top + 1 < LEVELS && (t & ((1L << (LEVEL_BITS * (top + 1))) - 1)) == 0)
+			++top;
+		for (int level = top; level > 0; --level)
+			Cascade(level, static_cast<int>((t >> (LEVEL_BITS * level)) & (SLOTS - 1)));
+
+		FireCurrent();
+	}
+
+	m_InTurn = inTurn;
+	m_Turn = latched;
+}
+
+void TimerWheel::Clear()
+{
+	m_Nodes.clear();
+	m_FreeNodes.clear();
+	for (auto& level : m_Slots)
+		std::fill(std::begin(level), std::end(level), -1);
+	m_PendingCount = 0;
+}
+
+int32_t TimerWheel::Lookup(TimerId id) const
+{
+	const uint32_t index = id & 0xFFFF;
+	if (index >= m_Nodes.size())
+		return -1;
+
+	const Node& node = m_Nodes[index];
+	return node.active && node.generation == (id >> 16) ? static_cast<int32_t>(index) : -1;
+}
+
+int32_t TimerWheel::AllocNode()
+{
+	int32_t index;
+	if (!m_FreeNodes.empty())
+	{
+		index = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+	}
+	else if (m_Nodes.size() < MAX_NODES)
+	{
+		index = static_cast<int32_t>(m_Nodes.size());
+		m_Nodes.emplace_back();
+	}
+	else
+	{
+		return -1;
+	}
+
+	m_Nodes[index].active = true;
+	++m_PendingCount;
+	return index;
+}
+
+void TimerWheel::FreeNode(int32_t index)
+{
+	Node& node = m_Nodes[index];
+	node.active = false;
+	node.level = -1;
+	// Generation 0 is never used so no id can ever be INVALID_TIMER_ID
+	if (++node.generation == 0)
+		node.generation = 1;
+
+	m_FreeNodes.push_back(index);
+	--m_PendingCount;
+}
+
+void TimerWheel::Insert(int32_t index)
+{
+	Node& node = m_Nodes[index];
+
+	// Anything further out than the wheel covers parks in the top level's
+	// furthest slot and gets re-placed from its real due turn on cascade
+	const long delta = std::max(node.due - m_CurrentTurn, 0L);
+	const long due = delta > MAX_DELTA ? m_CurrentTurn + MAX_DELTA : node.due;
+
+	int level = 0;
+	while (level + 1 < LEVELS && delta >= (1L << (LEVEL_BITS * (level + 1))))
+		++level;
+
+	const int slot = static_cast<int>((due >> (LEVEL_BITS * level)) & (SLOTS - 1));
+	node.level = static_cast<int8_t>(level);
+	node.slot = static_cast<uint8_t>(slot);
+	node.prev = -1;
+	node.next = m_Slots[level][slot];
+	if (node.next >= 0)
+		m_Nodes[node.next].prev = index;
+	m_Slots[level][slot] = index;
+}
+
+void TimerWheel::Unlink(int32_t index)
+{
+	Node& node = m_Nodes[index];
+	if (node.level < 0)
+		return;
+
+	if (node.prev >= 0)
+		m_Nodes[node.prev].next = node.next;
+	else
+		m_Slots[node.level][node.slot] = node.next;
+	if (node.next >= 0)
+		m_Nodes[node.next].prev = node.prev;
+
+	node.level = -1;
+	node.prev = node.next = -1;
+}
+
+void TimerWheel::Cascade(int level, int slot)
+{
+	int32_t index = m_Slots[level][slot];
+	m_Slots[level][slot] = -1;
+
+	while (index >= 0)
+	{
+		const int32_t next = m_Nodes[index].next;
+		Insert(index);
+		index = next;
+	}
+}
+
+void TimerWheel::FireCurrent()
+{
+	const int slot = static_cast<int>(m_CurrentTurn & (SLOTS - 1));
+	int32_t index = m_Slots[0][slot];
+	if (index < 0)
+		return;
+	m_Slots[0][slot] = -1;
+
+	// Detach everything first; callbacks are free to schedule or cancel.
+	// Keeping ids rather than indices means a timer cancelled by an earlier
+	// callback in this batch (whose node may already be reused) is skipped.
+	m_Firing.clear();
+	while (index >= 0)
+	{
+		Node& node = m_Nodes[index];
+		const int32_t next = node.next;
+		node.level = -1;
+		node.prev = node.next = -1;
+		m_Firing.push_back((static_cast<TimerId>(node.generation) << 16) | static_cast<TimerId>(index));
+		index = next;
+	}
+
+	// Slot order depends on insertion/cascade history, schedule order doesn't
+	std::sort(m_Firing.begin(), m_Firing.end(), [this](TimerId a, TimerId b)
+	{
+		return m_Nodes[a & 0xFFFF].seq < m_Nodes[b & 0xFFFF].seq;
+	});
+
+	for (TimerId id : m_Firing)
+	{
+		const int32_t i = Lookup(id);
+		if (i < 0)
+			continue;
+
+		const int eventId = m_Nodes[i].eventId;
+		const int param = m_Nodes[i].param;
+		FreeNode(i);
+
+		auto it = m_Callbacks.find(eventId);
+		if (it != m_Callbacks.end() && it->second)
+			it->second(param);
+	}
+}
+
+void TimerWheel::Save(SaveWriter& writer) const
+{
+	writer.BeginSection(TIMER_SAVE_TAG, TIMER_SAVE_VERSION);
+	writer.Write(static_cast<int32_t>(m_CurrentTurn));
+	writer.Write(m_NextSeq);
+
+	std::vector<uint16_t> generations(m_Nodes.size());
+	std::vector<SavedTimer> pending;
+	pending.reserve(m_PendingCount);
+	for (size_t i = 0; i < m_Nodes.size(); ++i)
+	{
+		const Node& node = m_Nodes[i];
+		generations[i] = node.generation;
+		if (node.active)
+			pending.push_back({ static_cast<int32_t>(i), static_cast<int32_t>(node.due), node.seq, node.eventId, node.param });
+	}
+
+	writer.WriteArray(std::span<const uint16_t>(generations));
+	writer.WriteArray(std::span<const int32_t>(m_FreeNodes));
+	writer.WriteArray(std::span<const SavedTimer>(pending));
+	writer.EndSection();
+}
+
+bool TimerWheel::Load(SaveReader& reader)
+{
+	Clear();
+
+	uint32_t version = 0;
+	if (!reader.OpenSection(TIMER_SAVE_TAG, version) || version != TIMER_SAVE_VERSION)
+		return false;
+
+	int32_t currentTurn = 0;
+	std::vector<uint16_t> generations;
+	std::vector<int32_t> freeNodes;
+	std::vector<SavedTimer> pending;
+	if (!reader.Read(currentTurn) || !reader.Read(m_NextSeq)
+		|| !reader.ReadArray(generations) || !reader.ReadArray(freeNodes) || !reader.ReadArray(pending))
+		return false;
+
+	const int32_t nodeCount = static_cast<int32_t>(generations.size());
+	if (generations.size() > MAX_NODES || freeNodes.size() > generations.size() || pending.size() > generations.size())
+		return false;
+
+	m_CurrentTurn = currentTurn;
+	m_Nodes.resize(nodeCount);
+	for (int32_t i = 0; i < nodeCount; ++i)
+		m_Nodes[i].generation = generations[i];
+	for (int32_t i : freeNodes)
+	{
+		if (i < 0 || i >= nodeCount)
+			return false;
+		m_FreeNodes.push_back(i);
+	}
+
+	for (const SavedTimer& timer : pending)
+	{
+		if (timer.index < 0 || timer.index >= nodeCount)
+			return false;
+
+		Node& node = m_Nodes[timer.index];
+		node.due = timer.due;
+		node.seq = timer.seq;
+		node.eventId = timer.eventId;
+		node.param = timer.param;
+		node.active = true;
+		++m_PendingCount;
+		Insert(timer.index);
+	}
+
+	return true;
+}
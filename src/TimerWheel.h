@@ -0,0 +1,138 @@
+#ifndef _TimerWheel_
+#define _TimerWheel_
+
+#include <ScriptUtils.h>
+
+#include "SaveBuffer.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Handle to a scheduled timer. Low 16 bits are the slot, high 16 bits a
+// generation count so ids of fired/cancelled timers go stale instead of
+// aliasing a newer timer. Ids survive Save/Load.
+typedef uint32_t TimerId;
+const TimerId INVALID_TIMER_ID = 0;
+
+// Called when a timer fires, with the param it was scheduled with.
+typedef void (*TimerCallback)(int param);
+
+// Hierarchical timing wheel driven by GetLockstepTurn(). Replaces polling
+// "has N seconds passed" conditions every Update: schedule an event once,
+// and its callback runs on exactly the turn it's due. Timers due on the
+// same turn fire in the order they were scheduled, so every client runs
+// them identically.
+//
+// Timers store an event id rather than a function pointer so they can be
+// saved. Register a callback per event id at startup (before Load runs),
+// e.g. timerWheel.RegisterEvent(EVENT_WAVE2, SpawnWave2).
+//
+// Cost is per pending timer cascade, not per turn: with nothing scheduled
+// Advance() does no work at all.
+class TimerWheel
+{
+public:
+	TimerWheel();
+
+	void RegisterEvent(int eventId, TimerCallback callback);
+
+	// Schedules eventId to fire turns turns from now (at least one).
+	TimerId Schedule(long turns, int eventId, int param = 0);
+
+	// Same as Schedule, converting through SecondsToTurns.
+	TimerId ScheduleSeconds(float seconds, int eventId, int param = 0)
+	{
+		return Schedule(SecondsToTurns(seconds), eventId, param);
+	}
+
+	// Returns false if the timer already fired or was cancelled.
+	bool Cancel(TimerId id);
+
+	bool IsPending(TimerId id) const { return Lookup(id) >= 0; }
+
+	// Turns until the timer fires, or -1 if it isn't pending.
+	long GetRemainingTurns(TimerId id) const;
+
+	// "Now" for Schedule is the turn set here. Call at the top of Update,
+	// before anything can schedule, and EndTurn at the bottom. Timers
+	// scheduled outside that, like from AddObject, ask the game instead.
+	void BeginTurn(long turn)
+	{
+		m_Turn = turn;
+		m_InTurn = true;
+	}
+
+	void EndTurn() { m_InTurn = false; }
+
+	// Runs every timer due up to and including turn. Call once per Update
+	// with the turn passed to BeginTurn.
+	void Advance(long turn);
+
+	long GetCurrentTurn() const { return m_CurrentTurn; }
+	size_t GetPendingCount() const { return m_PendingCount; }
+
+	// Drops every pending timer. Registered events are kept.
+	void Clear();
+
+	// Saved as the 'TIMR' section of the mission's save buffer. Call from
+	// the mission's Save/Load when missionSave is false.
+	void Save(SaveWriter& writer) const;
+	bool Load(SaveReader& reader);
+
+private:
+	static constexpr int LEVEL_BITS = 6;
+	static constexpr int SLOTS = 1 << LEVEL_BITS;
+	static constexpr int LEVELS = 4;
+	static constexpr long MAX_DELTA = (1L << (LEVEL_BITS * LEVELS)) - 1;
+	static constexpr uint32_t MAX_NODES = 0xFFFF;
+
+	struct Node
+	{
+		long due = 0;
+		uint32_t seq = 0;
+		int eventId = 0;
+		int param = 0;
+		uint16_t generation = 1;
+		bool active = false;
+		int8_t level = -1;
+		uint8_t slot = 0;
+		int32_t prev = -1;
+		int32_t next = -1;
+	};
+
+	// Returns the node index for id, or -1 if it isn't pending.
+	int32_t Lookup(TimerId id) const;
+
+	int32_t AllocNode();
+	void FreeNode(int32_t index);
+
+	// Places a node into the wheel slot its due turn maps to, relative to
+	// m_CurrentTurn.
+	void Insert(int32_t index);
+	void Unlink(int32_t index);
+
+	// Moves every timer in the given slot down to a lower level.
+	void Cascade(int level, int slot);
+
+	// Fires the level 0 slot for m_CurrentTurn.
+	void FireCurrent();
+
+	std::vector<Node> m_Nodes;
+	std::vector<int32_t> m_FreeNodes;
+	int32_t m_Slots[LEVELS][SLOTS];
+
+	std::unordered_map<int, TimerCallback> m_Callbacks;
+
+	long m_CurrentTurn = -1;
+	// Set by BeginTurn, while m_InTurn
+	long m_Turn = -1;
+	bool m_InTurn = false;
+	uint32_t m_NextSeq = 0;
+	size_t m_PendingCount = 0;
+
+	// Scratch for FireCurrent, kept around so firing doesn't allocate
+	std::vector<TimerId> m_Firing;
+};
+
+#endif
@@ -0,0 +1,314 @@
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define VECTORMATH_SSE 1
+#include <emmintrin.h>
+#else
+#define VECTORMATH_SSE 0
+#endif
+
+namespace
+{
+	// Past this the arc is too short for sin() to divide by safely
+	constexpr float SLERP_LERP_THRESHOLD = 0.9995f;
+
+	// Weights for Slerp. wb carries the sign flip for the shortest arc.
+	// Returns true if the result needs normalizing (lerp fallback).
+	bool SlerpWeights(float dot, float t, float& wa, float& wb)
+	{
+		float sign = 1.0f;
+		if (dot < 0.0f)
+		{
+			dot = -dot;
+			sign = -1.0f;
+		}
+
+		bool lerp = false;
+		if (dot > SLERP_LERP_THRESHOLD)
+		{
+			wa = 1.0f - t;
+			wb = t;
+			lerp = true;
+		}
+		else
+		{
+			const float theta = std::acos(dot);
+			const float sinTheta = std::sin(theta);
+			wa = std::sin((1.0f - t) * theta) / sinTheta;
+			wb = std::sin(t * theta) / sinTheta;
+		}
+		wb *= sign;
+		return lerp;
+	}
+
+#if VECTORMATH_SSE
+	// 4 Vectors are 48 bytes, 3 registers: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3.
+	// These shuffle them to and from one register per component.
+	inline void LoadVectors4(const Vector* v, __m128& x, __m128& y, __m128& z)
+	{
+		const float* p = &v->x;
+		const __m128 a = _mm_loadu_ps(p);
+		const __m128 b = _mm_loadu_ps(p + 4);
+		const __m128 c = _mm_loadu_ps(p + 8);
+
+		const __m128 x23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2));
+		x = _mm_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+		const __m128 y01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1));
+		const __m128 y23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3));
+		y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 z01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2));
+		const __m128 z23 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0));
+		z = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	inline void StoreVectors4(Vector* v, __m128 x, __m128 y, __m128 z)
+	{
+		const __m128 xy01 = _mm_unpacklo_ps(x, y);
+		const __m128 xy23 = _mm_unpackhi_ps(x, y);
+
+		const __m128 z0x1 = _mm_shuffle_ps(z, xy01, _MM_SHUFFLE(0, 2, 0, 0));
+		const __m128 a = _mm_shuffle_ps(xy01, z0x1, _MM_SHUFFLE(2, 0, 1, 0));
+		const __m128 y1z1 = _mm_shuffle_ps(xy01, z, _MM_SHUFFLE(0, 1, 0, 3));
+		const __m128 b = _mm_shuffle_ps(y1z1, xy23, _MM_SHUFFLE(1, 0, 2, 0));
+		const __m128 z2x3 = _mm_shuffle_ps(z, xy23, _MM_SHUFFLE(0, 2, 0, 2));
+		const __m128 y3z3 = _mm_shuffle_ps(xy23, z, _MM_SHUFFLE(0, 3, 0, 3));
+		const __m128 c = _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0));
+
+		float* p = &v->x;
+		_mm_storeu_ps(p, a);
+		_mm_storeu_ps(p + 4, b);
+		_mm_storeu_ps(p + 8, c);
+	}
+
+	// Same operation order as VectorMath::Dot, so the results match exactly
+	inline __m128 Dot4(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+
+	// x * m.right + y * m.up + z * m.front (+ m.posit), one component at a time
+	template <bool Translate>
+	void TransformBatch(const Matrix& m, std::span<const Vector> in, std::span<Vector> out)
+	{
+		const __m128 rx = _mm_set1_ps(m.right.x), ry = _mm_set1_ps(m.right.y), rz = _mm_set1_ps(m.right.z);
+		const __m128 ux = _mm_set1_ps(m.up.x), uy = _mm_set1_ps(m.up.y), uz = _mm_set1_ps(m.up.z);
+		const __m128 fx = _mm_set1_ps(m.front.x), fy = _mm_set1_ps(m.front.y), fz = _mm_set1_ps(m.front.z);
+		const __m128 px = _mm_set1_ps(m.posit.x), py = _mm_set1_ps(m.posit.y), pz = _mm_set1_ps(m.posit.z);
+
+		size_t i = 0;
+		for (; i + 4 <= in.size(); i += 4)
+		{
+			__m128 x, y, z;
+			LoadVectors4(&in[i], x, y, z);
+
+			__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, rx), _mm_mul_ps(y, ux)), _mm_mul_ps(z, fx));
+			__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, ry), _mm_mul_ps(y, uy)), _mm_mul_ps(z, fy));
+			__m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, rz), _mm_mul_ps(y, uz)), _mm_mul_ps(z, fz));
+			if constexpr (Translate)
+			{
+				ox = _mm_add_ps(ox, px);
+				oy = _mm_add_ps(oy, py);
+				oz = _mm_add_ps(oz, pz);
+			}
+			StoreVectors4(&out[i], ox, oy, oz);
+		}
+		for (; i < in.size(); ++i)
+			out[i] = Translate ? VectorMath::TransformPoint(m, in[i]) : VectorMath::TransformDirection(m, in[i]);
+	}
+#endif
+}
+
+// Declared in ScriptUtils.h for the DLL to provide
+Vector Normalize_Vector(const Vector& A)
+{
+	return VectorMath::Normalize(A);
+}
+
+Quaternion VectorMath::Slerp(const Quaternion& a, const Quaternion& b, float t)
+{
+	const float dot = a.s * b.s + a.v.x * b.v.x + a.v.y * b.v.y + a.v.z * b.v.z;
+
+	float wa, wb;
+	const bool lerp = SlerpWeights(dot, t, wa, wb);
+
+	Quaternion r(a.s * wa + b.s * wb, Vector(a.v.x * wa + b.v.x * wb, a.v.y * wa + b.v.y * wb, a.v.z * wa + b.v.z * wb));
+	if (lerp)
+	{
+		const float inv = 1.0f / std::sqrt(r.s * r.s + r.v.x * r.v.x + r.v.y * r.v.y + r.v.z * r.v.z);
+		r.s *= inv;
+		r.v.x *= inv;
+		r.v.y *= inv;
+		r.v.z *= inv;
+	}
+	return r;
+}
+
+void VectorMath::TransformPoints(const Matrix& m, std::span<const Vector> points, std::span<Vector> out)
+{
+#if VECTORMATH_SSE
+	TransformBatch<true>(m, points, out);
+#else
+	for (size_t i = 0; i < points.size(); ++i)
+		out[i] = TransformPoint(m, points[i]);
+#endif
+}
+
+void VectorMath::TransformDirections(const Matrix& m, std::span<const Vector> directions, std::span<Vector> out)
+{
+#if VECTORMATH_SSE
+	TransformBatch<false>(m, directions, out);
+#else
+	for (size_t i = 0; i < directions.size(); ++i)
+		out[i] = TransformDirection(m, directions[i]);
+#endif
+}
+
+void VectorMath::Dot(std::span<const Vector> a, std::span<const Vector> b, std::span<float> out)
+{
+	const size_t count = std::min(a.size(), b.size());
+	size_t i = 0;
+#if VECTORMATH_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 ax, ay, az, bx, by, bz;
+		LoadVectors4(&a[i], ax, ay, az);
+		LoadVectors4(&b[i], bx, by, bz);
+		_mm_storeu_ps(&out[i], Dot4(ax, ay, az, bx, by, bz));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = Dot(a[i], b[i]);
+}
+
+void VectorMath::Cross(std::span<const Vector> a, std::span<const Vector> b, std::span<Vector> out)
+{
+	const size_t count = std::min(a.size(), b.size());
+	size_t i = 0;
+#if VECTORMATH_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 ax, ay, az, bx, by, bz;
+		LoadVectors4(&a[i], ax, ay, az);
+		LoadVectors4(&b[i], bx, by, bz);
+		const __m128 cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+		const __m128 cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+		const __m128 cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+		StoreVectors4(&out[i], cx, cy, cz);
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = Cross(a[i], b[i]);
+}
+
+void VectorMath::Normalize(std::span<const Vector> vectors, std::span<Vector> out)
+{
+	size_t i = 0;
+#if VECTORMATH_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= vectors.size(); i += 4)
+	{
+		__m128 x, y, z;
+		LoadVectors4(&vectors[i], x, y, z);
+		const __m128 lengthSq = Dot4(x, y, z, x, y, z);
+		// !(lengthSq <= 0) rather than lengthSq > 0, so NaNs go through like the scalar version
+		const __m128 valid = _mm_cmpnle_ps(lengthSq, zero);
+		const __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+		StoreVectors4(&out[i], _mm_and_ps(_mm_mul_ps(x, inv), valid), _mm_and_ps(_mm_mul_ps(y, inv), valid), _mm_and_ps(_mm_mul_ps(z, inv), valid));
+	}
+#endif
+	for (; i < vectors.size(); ++i)
+		out[i] = Normalize(vectors[i]);
+}
+
+void VectorMath::DistanceSquared(std::span<const Vector> points, const Vector& origin, std::span<float> out)
+{
+	size_t i = 0;
+#if VECTORMATH_SSE
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	for (; i + 4 <= points.size(); i += 4)
+	{
+		__m128 x, y, z;
+		LoadVectors4(&points[i], x, y, z);
+		const __m128 dx = _mm_sub_ps(x, ox);
+		const __m128 dy = _mm_sub_ps(y, oy);
+		const __m128 dz = _mm_sub_ps(z, oz);
+		_mm_storeu_ps(&out[i], Dot4(dx, dy, dz, dx, dy, dz));
+	}
+#endif
+	for (; i < points.size(); ++i)
+		out[i] = DistanceSquared(points[i], origin);
+}
+
+void VectorMath::DistanceSquared(std::span<const Vector> a, std::span<const Vector> b, std::span<float> out)
+{
+	const size_t count = std::min(a.size(), b.size());
+	size_t i = 0;
+#if VECTORMATH_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 ax, ay, az, bx, by, bz;
+		LoadVectors4(&a[i], ax, ay, az);
+		LoadVectors4(&b[i], bx, by, bz);
+		const __m128 dx = _mm_sub_ps(ax, bx);
+		const __m128 dy = _mm_sub_ps(ay, by);
+		const __m128 dz = _mm_sub_ps(az, bz);
+		_mm_storeu_ps(&out[i], Dot4(dx, dy, dz, dx, dy, dz));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = DistanceSquared(a[i], b[i]);
+}
+
+void VectorMath::Slerp(std::span<const Quaternion> a, std::span<const Quaternion> b, float t, std::span<Quaternion> out)
+{
+	const size_t count = std::min(a.size(), b.size());
+	size_t i = 0;
+#if VECTORMATH_SSE
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		// A Quaternion is exactly one register (s, x, y, z), transpose to one register per component
+		__m128 as = _mm_loadu_ps(&a[i].s), ax = _mm_loadu_ps(&a[i + 1].s), ay = _mm_loadu_ps(&a[i + 2].s), az = _mm_loadu_ps(&a[i + 3].s);
+		__m128 bs = _mm_loadu_ps(&b[i].s), bx = _mm_loadu_ps(&b[i + 1].s), by = _mm_loadu_ps(&b[i + 2].s), bz = _mm_loadu_ps(&b[i + 3].s);
+		_MM_TRANSPOSE4_PS(as, ax, ay, az);
+		_MM_TRANSPOSE4_PS(bs, bx, by, bz);
+
+		alignas(16) float dots[4];
+		_mm_store_ps(dots, _mm_add_ps(Dot4(as, ax, ay, bs, bx, by), _mm_mul_ps(az, bz)));
+
+		// The trig is per lane, the blend below is batched
+		alignas(16) float wa[4], wb[4];
+		alignas(16) uint32_t lerpMask[4];
+		for (int lane = 0; lane < 4; ++lane)
+			lerpMask[lane] = SlerpWeights(dots[lane], t, wa[lane], wb[lane]) ? 0xFFFFFFFFu : 0u;
+
+		const __m128 wA = _mm_load_ps(wa);
+		const __m128 wB = _mm_load_ps(wb);
+		__m128 rs = _mm_add_ps(_mm_mul_ps(as, wA), _mm_mul_ps(bs, wB));
+		__m128 rx = _mm_add_ps(_mm_mul_ps(ax, wA), _mm_mul_ps(bx, wB));
+		__m128 ry = _mm_add_ps(_mm_mul_ps(ay, wA), _mm_mul_ps(by, wB));
+		__m128 rz = _mm_add_ps(_mm_mul_ps(az, wA), _mm_mul_ps(bz, wB));
+
+		// Renormalize the lerp lanes only
+		const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rs, rs), _mm_mul_ps(rx, rx)), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+		const __m128 lerp = _mm_load_ps(reinterpret_cast<const float*>(lerpMask));
+		const __m128 scale = _mm_or_ps(_mm_and_ps(lerp, _mm_div_ps(one, _mm_sqrt_ps(lengthSq))), _mm_andnot_ps(lerp, one));
+		rs = _mm_mul_ps(rs, scale);
+		rx = _mm_mul_ps(rx, scale);
+		ry = _mm_mul_ps(ry, scale);
+		rz = _mm_mul_ps(rz, scale);
+
+		_MM_TRANSPOSE4_PS(rs, rx, ry, rz);
+		_mm_storeu_ps(&out[i].s, rs);
+		_mm_storeu_ps(&out[i + 1].s, rx);
+		_mm_storeu_ps(&out[i + 2].s, ry);
+		_mm_storeu_ps(&out[i + 3].s, rz);
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = Slerp(a[i], b[i], t);
+}
@@ -0,0 +1,98 @@
+#ifndef _VectorMath_
+#define _VectorMath_
+
+#include <ScriptUtils.h>
+
+#include <cmath>
+#include <span>
+
+// The kernels below load these straight from memory, so they have to stay
+// exactly as the game lays them out.
+static_assert(sizeof(Vector) == 12, "Vector layout changed");
+static_assert(sizeof(Matrix) == 64, "Matrix layout changed");
+static_assert(sizeof(Quaternion) == 16, "Quaternion layout changed");
+
+// Math on the ScriptUtils.h Vector/Matrix/Quaternion types.
+//
+// The scalar functions are for one-offs. The span versions work on whole
+// arrays 4 at a time with SSE (plain loops if SSE isn't available), and
+// handle the leftover elements with the scalar functions. Both round the
+// same way, so batched and scalar results are bit-identical, which keeps
+// them safe to use in lockstep code.
+//
+// For the span versions out must be at least as long as the inputs, and
+// may be the same array as an input.
+namespace VectorMath
+{
+	inline float Dot(const Vector& a, const Vector& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline Vector Cross(const Vector& a, const Vector& b)
+	{
+		return Vector(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	inline float DistanceSquared(const Vector& a, const Vector& b)
+	{
+		const float dx = a.x - b.x;
+		const float dy = a.y - b.y;
+		const float dz = a.z - b.z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	// Returns a zero vector for zero-length input.
+	inline Vector Normalize(const Vector& a)
+	{
+		const float lengthSq = Dot(a, a);
+		if (lengthSq <= 0.0f)
+			return Vector(0.0f, 0.0f, 0.0f);
+		const float inv = 1.0f / std::sqrt(lengthSq);
+		return Vector(a.x * inv, a.y * inv, a.z * inv);
+	}
+
+	// Point from m's local space to world space, including the translation.
+	inline Vector TransformPoint(const Matrix& m, const Vector& p)
+	{
+		return Vector(
+			p.x * m.right.x + p.y * m.up.x + p.z * m.front.x + m.posit.x,
+			p.x * m.right.y + p.y * m.up.y + p.z * m.front.y + m.posit.y,
+			p.x * m.right.z + p.y * m.up.z + p.z * m.front.z + m.posit.z);
+	}
+
+	// Same as TransformPoint, without the translation.
+	inline Vector TransformDirection(const Matrix& m, const Vector& d)
+	{
+		return Vector(
+			d.x * m.right.x + d.y * m.up.x + d.z * m.front.x,
+			d.x * m.right.y + d.y * m.up.y + d.z * m.front.y,
+			d.x * m.right.z + d.y * m.up.z + d.z * m.front.z);
+	}
+
+	// Spherical interpolation along the shortest arc, t in [0, 1]. Nearly
+	// parallel inputs fall back to a normalized lerp.
+	Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+
+	void TransformPoints(const Matrix& m, std::span<const Vector> points, std::span<Vector> out);
+	void TransformDirections(const Matrix& m, std::span<const Vector> directions, std::span<Vector> out);
+
+	// out[i] = Dot(a[i], b[i])
+	void Dot(std::span<const Vector> a, std::span<const Vector> b, std::span<float> out);
+
+	// out[i] = Cross(a[i], b[i])
+	void Cross(std::span<const Vector> a, std::span<const Vector> b, std::span<Vector> out);
+
+	void Normalize(std::span<const Vector> vectors, std::span<Vector> out);
+
+	// out[i] = DistanceSquared(points[i], origin)
+	void DistanceSquared(std::span<const Vector> points, const Vector& origin, std::span<float> out);
+
+	// out[i] = DistanceSquared(a[i], b[i])
+	void DistanceSquared(std::span<const Vector> a, std::span<const Vector> b, std::span<float> out);
+
+	// out[i] = Slerp(a[i], b[i], t)
+	void Slerp(std::span<const Quaternion> a, std::span<const Quaternion> b, float t, std::span<Quaternion> out);
+}
+
+#endif
@@ -0,0 +1,261 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+void WorkerPool::Start(int threadCount)
+{
+	Shutdown();
+
+	// Leave the game its main and render threads
+	if (threadCount <= 0)
+		threadCount = static_cast<int>(std::thread::hardware_concurrency()) - 2;
+	threadCount = std::clamp(threadCount, 1, MAX_THREADS);
+
+	m_Threads.reserve(threadCount);
+	for (int i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&WorkerPool::WorkerMain, this);
+}
+
+void WorkerPool::Shutdown(bool processExiting)
+{
+	if (processExiting)
+	{
+		// Windows has already killed the workers, possibly holding m_Mutex,
+		// so just let go of the handles
+		for (std::thread& thread : m_Threads)
+			thread.detach();
+		m_Threads.clear();
+		return;
+	}
+
+	if (!m_Threads.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_WorkReady.notify_all();
+
+		for (std::thread& thread : m_Threads)
+			thread.join();
+		m_Threads.clear();
+		m_Stopping = false;
+	}
+
+	m_Queue.clear();
+	m_Jobs.clear();
+}
+
+void WorkerPool::Submit(long joinTurn, Work work, Merge merge)
+{
+	++m_Stats.submitted;
+	m_Jobs.push_back(std::make_unique<Job>(Job{ joinTurn, std::move(work), std::move(merge), JOB_QUEUED }));
+
+	// Without workers the job waits for Join to run it
+	if (m_Threads.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queue.push_back(m_Jobs.back().get());
+	}
+	m_WorkReady.notify_one();
+}
+
+void WorkerPool::Join(long turn)
+{
+	// Merges can submit more jobs, so go by index and compact as we go
+	size_t kept = 0;
+	for (size_t i = 0; i < m_Jobs.size(); ++i)
+	{
+		if (m_Jobs[i]->joinTurn > turn)
+		{
+			if (kept != i)
+				m_Jobs[kept] = std::move(m_Jobs[i]);
+			++kept;
+			continue;
+		}
+
+		Job& job = *m_Jobs[i];
+		Finish(job);
+		if (job.merge)
+			job.merge();
+		++m_Stats.merged;
+	}
+	m_Jobs.resize(kept);
+}
+
+void WorkerPool::Cancel()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Queue.clear();
+	for (const std::unique_ptr<Job>& job : m_Jobs)
+		m_JobDone.wait(lock, [&job] { return job->state != JOB_RUNNING; });
+	lock.unlock();
+
+	m_Jobs.clear();
+}
+
+void WorkerPool::RunParallel(size_t count, size_t grain, ChunkFn fn, void* context)
+{
+	grain = grain > 0 ? grain : 1;
+	const uint64_t chunks = (count + grain - 1) / grain;
+	if (chunks == 0)
+		return;
+
+	ParallelRun run;
+	run.fn = fn;
+	run.context = context;
+	run.count = count;
+	run.grain = grain;
+	run.slots = static_cast<int>(std::min<uint64_t>(m_Threads.size() + 1, chunks));
+	run.nextSlot = 1;
+	run.steals.store(0, std::memory_order_relaxed);
+
+	// Contiguous shares to start with, so a participant mostly walks memory in order
+	for (int slot = 0; slot < run.slots; ++slot)
+	{
+		const uint64_t lo = chunks * slot / run.slots;
+		const uint64_t hi = chunks * (slot + 1) / run.slots;
+		run.ranges[slot].value.store(lo | (hi << 32), std::memory_order_relaxed);
+	}
+	++m_Stats.parallelRuns;
+
+	if (run.slots > 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Parallel = &run;
+		}
+		m_WorkReady.notify_all();
+	}
+
+	Participate(run, 0);
+
+	// Every chunk is done or being done. Close the run to latecomers and
+	// wait out the workers still finishing theirs.
+	if (run.slots > 1)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Parallel = nullptr;
+		m_ParallelDone.wait(lock, [this] { return m_ParallelWorkers == 0; });
+	}
+	m_Stats.steals += run.steals.load(std::memory_order_relaxed);
+}
+
+void WorkerPool::Participate(ParallelRun& run, int slot)
+{
+	auto execute = [&run](uint64_t chunk)
+	{
+		const size_t begin = static_cast<size_t>(chunk) * run.grain;
+		run.fn(run.context, static_cast<uint32_t>(chunk), begin, std::min(begin + run.grain, run.count));
+	};
+
+	// Own share from the front
+	std::atomic<uint64_t>& own = run.ranges[slot].value;
+	uint64_t range = own.load(std::memory_order_acquire);
+	for (;;)
+	{
+		const uint64_t lo = range & 0xFFFFFFFF;
+		const uint64_t hi = range >> 32;
+		if (lo >= hi)
+			break;
+		if (own.compare_exchange_weak(range, (lo + 1) | (hi << 32), std::memory_order_acq_rel))
+		{
+			execute(lo);
+			range = own.load(std::memory_order_acquire);
+		}
+	}
+
+	// Then everyone else's from the back, until a full pass finds nothing
+	bool found = true;
+	while (found)
+	{
+		found = false;
+		for (int i = 1; i < run.slots; ++i)
+		{
+			std::atomic<uint64_t>& victim = run.ranges[(slot + i) % run.slots].value;
+			uint64_t theirs = victim.load(std::memory_order_acquire);
+			for (;;)
+			{
+				const uint64_t lo = theirs & 0xFFFFFFFF;
+				const uint64_t hi = theirs >> 32;
+				if (lo >= hi)
+					break;
+				if (victim.compare_exchange_weak(theirs, lo | ((hi - 1) << 32), std::memory_order_acq_rel))
+				{
+					run.steals.fetch_add(1, std::memory_order_relaxed);
+					execute(hi - 1);
+					found = true;
+					theirs = victim.load(std::memory_order_acquire);
+				}
+			}
+		}
+	}
+}
+
+void WorkerPool::Finish(Job& job)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	if (job.state == JOB_QUEUED)
+	{
+		auto it = std::find(m_Queue.begin(), m_Queue.end(), &job);
+		if (it != m_Queue.end())
+			m_Queue.erase(it);
+		job.state = JOB_RUNNING;
+		lock.unlock();
+
+		job.work();
+		++m_Stats.ranOnMain;
+
+		lock.lock();
+		job.state = JOB_DONE;
+		return;
+	}
+
+	if (job.state == JOB_RUNNING)
+		++m_Stats.waited;
+	m_JobDone.wait(lock, [&job] { return job.state == JOB_DONE; });
+}
+
+void WorkerPool::WorkerMain()
+{
+	for (;;)
+	{
+		Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkReady.wait(lock, [this] { return m_Stopping || !m_Queue.empty() || (m_Parallel && m_Parallel->nextSlot < m_Parallel->slots); });
+			if (m_Stopping)
+				break;
+
+			// The main thread is blocked on a ParallelFor, that comes first
+			if (m_Parallel && m_Parallel->nextSlot < m_Parallel->slots)
+			{
+				ParallelRun& run = *m_Parallel;
+				const int slot = run.nextSlot++;
+				++m_ParallelWorkers;
+				lock.unlock();
+
+				Participate(run, slot);
+
+				lock.lock();
+				if (--m_ParallelWorkers == 0)
+					m_ParallelDone.notify_all();
+				continue;
+			}
+
+			job = m_Queue.front();
+			m_Queue.pop_front();
+			job->state = JOB_RUNNING;
+		}
+
+		job->work();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			job->state = JOB_DONE;
+		}
+		m_JobDone.notify_all();
+	}
+}
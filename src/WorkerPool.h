@@ -0,0 +1,218 @@
+#ifndef _WorkerPool_
+#define _WorkerPool_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Worker threads for mission work too big for one tick, such as long
+// searches or whole-map scoring.
+//
+// A job is two parts. work runs on a worker and must only touch what it
+// was given: no game exports (the game isn't thread safe) and nothing
+// the main thread might change meanwhile. merge runs on the main thread
+// at the job's join turn and applies the result. Join waits for every
+// job due by then (running it right there if no worker has picked it
+// up) and merges them in submission order. Results therefore land on the
+// same turn and in the same order on every client, however the threads
+// happened to run.
+//
+// With no threads started, jobs just run on the main thread at their
+// join turn, so the results are the same either way.
+//
+// Jobs aren't saved. Like coroutines, resubmit them from PostLoad.
+//
+// ParallelFor and ParallelReduce are for loops over the entity table that
+// need an answer this tick. The range is cut into chunks of grain items,
+// which only depends on the arguments. Every participant (the main
+// thread, plus whichever workers aren't busy with a job) starts on its
+// own share of the chunks and steals from the back of the others' once
+// it runs out. Reductions combine the per-chunk results in a fixed
+// pairwise tree, so a float sum comes out bit-identical whatever the
+// thread count.
+class WorkerPool
+{
+public:
+	static constexpr int MAX_THREADS = 16;
+
+	using Work = std::function<void()>;
+	using Merge = std::function<void()>;
+
+	// ParallelReduce takes its per-chunk results from scratch, e.g. the mission's FrameArena
+	explicit WorkerPool(std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) : m_Scratch(scratch) {}
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	~WorkerPool() { Shutdown(); }
+
+	// Starts threadCount workers, or a couple fewer than the CPU has cores
+	// for 0. Call from InitialSetup.
+	void Start(int threadCount = 0);
+
+	// Stops and joins the workers and drops every pending job. Call from
+	// PostRun, before the DLL is unloaded. Joining from DllMain would
+	// deadlock on the loader lock, so the only call from there is with
+	// processExiting (lpReserved != NULL): Windows has already killed the
+	// threads by then, and their handles are just let go.
+	void Shutdown(bool processExiting = false);
+
+	int GetThreadCount() const { return static_cast<int>(m_Threads.size()); }
+
+	// Queues a job to be merged at joinTurn. Main thread only.
+	void Submit(long joinTurn, Work work, Merge merge = {});
+
+	// Waits for every job due by turn and runs their merges in the order
+	// they were submitted. Call once per Update with GetLockstepTurn().
+	void Join(long turn);
+
+	// Drops every pending job without merging it, after waiting out any
+	// that are running. Call from PostLoad since handles change.
+	void Cancel();
+
+	size_t GetPendingCount() const { return m_Jobs.size(); }
+
+	// Calls body(begin, end) over [0, count) in chunks of grain, on the
+	// main thread and any idle workers, and returns once all of it is
+	// done. Chunks run in no particular order, so body must only write to
+	// its own items. Main thread only, and not from inside another body.
+	template <typename Body>
+	void ParallelFor(size_t count, size_t grain, Body&& body)
+	{
+		using Fn = std::remove_reference_t<Body>;
+		auto chunk = [](void* context, uint32_t, size_t begin, size_t end) { (*static_cast<Fn*>(context))(begin, end); };
+		RunParallel(count, grain, chunk, &body);
+	}
+
+	// map(begin, end) returns a chunk's T, combine(a, b) merges two in
+	// order. The result only depends on count, grain, identity and the
+	// functions, never on the number of threads.
+	template <typename T, typename Map, typename Combine>
+	T ParallelReduce(size_t count, size_t grain, T identity, Map&& map, Combine&& combine)
+	{
+		grain = grain > 0 ? grain : 1;
+		const size_t chunks = (count + grain - 1) / grain;
+		if (chunks == 0)
+			return identity;
+
+		std::pmr::vector<T> partials(chunks, identity, m_Scratch);
+		struct Context
+		{
+			Map& map;
+			T* partials;
+		} context{ map, partials.data() };
+		auto chunk = [](void* context, uint32_t index, size_t begin, size_t end)
+		{
+			Context& c = *static_cast<Context*>(context);
+			c.partials[index] = c.map(begin, end);
+		};
+		RunParallel(count, grain, chunk, &context);
+
+		// Same tree for the same chunk count: neighbours, then pairs of pairs...
+		for (size_t step = 1; step < chunks; step *= 2)
+		{
+			for (size_t i = 0; i + step < chunks; i += 2 * step)
+				partials[i] = combine(partials[i], partials[i + step]);
+		}
+		return partials[0];
+	}
+
+	struct Stats
+	{
+		uint64_t submitted;
+		uint64_t merged;
+		// Jobs Join had to run itself because no worker got to them first
+		uint64_t ranOnMain;
+		// Jobs Join found still running and had to wait for
+		uint64_t waited;
+		uint64_t parallelRuns;
+		// Chunks taken from another participant's share
+		uint64_t steals;
+	};
+
+	const Stats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = {}; }
+
+private:
+	enum JobState : uint8_t
+	{
+		JOB_QUEUED,
+		JOB_RUNNING,
+		JOB_DONE,
+	};
+
+	struct Job
+	{
+		long joinTurn;
+		Work work;
+		Merge merge;
+		// Changes under m_Mutex only
+		JobState state;
+	};
+
+	using ChunkFn = void (*)(void* context, uint32_t chunk, size_t begin, size_t end);
+
+	static constexpr size_t CACHE_LINE = 64;
+
+	// A participant's share of the chunks, as a [lo, hi) range packed into
+	// one word, lo in the low half: the owner takes from lo, thieves from
+	// hi. One per cache line, so a CAS on one share doesn't bounce the line
+	// holding the others.
+	struct alignas(CACHE_LINE) ChunkRange
+	{
+		std::atomic<uint64_t> value;
+	};
+
+	// One ParallelFor
+	struct ParallelRun
+	{
+		ChunkFn fn;
+		void* context;
+		size_t count;
+		size_t grain;
+		int slots;
+		// Next slot for a worker that joins in, slot 0 is the main thread's
+		int nextSlot;
+		ChunkRange ranges[MAX_THREADS + 1];
+		// Bumped by every steal, so kept off the ranges' lines too
+		alignas(CACHE_LINE) std::atomic<uint64_t> steals;
+	};
+
+	void RunParallel(size_t count, size_t grain, ChunkFn fn, void* context);
+
+	// Works through slot's chunks and then everyone else's
+	static void Participate(ParallelRun& run, int slot);
+
+	void WorkerMain();
+
+	// Runs job here if it hasn't started, otherwise waits for it
+	void Finish(Job& job);
+
+	std::vector<std::thread> m_Threads;
+
+	// Guards m_Queue, m_Stopping and every Job::state
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkReady;
+	std::condition_variable m_JobDone;
+	std::deque<Job*> m_Queue;
+	bool m_Stopping = false;
+
+	// The ParallelFor in progress, and how many workers are still in it
+	ParallelRun* m_Parallel = nullptr;
+	int m_ParallelWorkers = 0;
+	std::condition_variable m_ParallelDone;
+
+	std::pmr::memory_resource* m_Scratch;
+
+	// Main thread only, in submission order
+	std::vector<std::unique_ptr<Job>> m_Jobs;
+	Stats m_Stats{};
+};
+
+#endif
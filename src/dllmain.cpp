@@ -1,6 +1,11 @@
 // dllmain.cpp : Defines the entry point for the DLL application.
 #include <Windows.h>
 
+#include "WorkerPool.h"
+
+// Defined in Mission.cpp
+extern WorkerPool workerPool;
+
 BOOL APIENTRY DllMain( HMODULE hModule,
                        DWORD  ul_reason_for_call,
                        LPVOID lpReserved
@@ -13,7 +18,13 @@ BOOL APIENTRY DllMain( HMODULE hModule,
         break;
     case DLL_THREAD_ATTACH:
     case DLL_THREAD_DETACH:
+        break;
     case DLL_PROCESS_DETACH:
+        // PostRun has already joined the workers. lpReserved is set when the
+        // process is exiting without getting that far, and the threads are
+        // gone; just let go of their handles.
+        if (lpReserved != nullptr)
+            workerPool.Shutdown(true);
         break;
     }
     return TRUE;